@@ -0,0 +1,386 @@
+// Headless benchmark. Steps a suite of standard workloads on every engine and
+// prints the timings as JSON, so it runs on build machines without a display:
+//
+//   bench [--generations n] [--sizes 256,1024] [--threads 1,8]
+//         [--kernels scalar,avx2] [--engines grid,chunk_map,hashlife]
+//         [--workloads soup,acorn] [--rule B3/S23] [--pattern breeder.rle]
+//
+// or runs a soup census instead, once per thread count, and writes what it found:
+//
+//   bench --census 100000 [--seed 1] [--census-file census.txt] [--threads 8]
+#include <census.hpp>
+#include <grid.hpp>
+#include <grid_kernel.hpp>
+#include <hashlife.hpp>
+#include <pattern_file.hpp>
+#include <chunk_map.hpp>
+#include <rule.hpp>
+#include <algorithm>
+#include <bit>
+#include <chrono>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#if defined(_WIN32)
+#define NOMINMAX
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+
+namespace
+{
+	struct workload
+	{
+		const char* name_;
+		/** Rows of 'O' (alive) and '.' (dead) separated by '\n', or nullptr for a 50% soup of the whole board. */
+		const char* cells_;
+		/** A pattern file to read instead of cells_. */
+		const char* path_;
+	};
+
+	const workload workloads[] = {
+		{ "soup", nullptr, nullptr },
+		{ "r_pentomino",
+			".OO\n"
+			"OO.\n"
+			".O.", nullptr },
+		{ "acorn",
+			".O.....\n"
+			"...O...\n"
+			"OO..OOO", nullptr },
+		{ "gosper_gun",
+			"........................O...........\n"
+			"......................O.O...........\n"
+			"............OO......OO............OO\n"
+			"...........O...O....OO............OO\n"
+			"OO........O.....O...OO..............\n"
+			"OO........O...O.OO....O.O...........\n"
+			"..........O.....O.......O...........\n"
+			"...........O...O....................\n"
+			"............OO......................", nullptr },
+		// Grows without bound by laying blocks behind a switch engine.
+		{ "switch_engine",
+			"OOO.O\n"
+			"O....\n"
+			"...OO\n"
+			".OO.O\n"
+			"O.O.O", nullptr },
+	};
+
+	const char* engine_names[] = { "grid", "chunk_map", "hashlife" };
+	const kernel_isa all_kernels[] = { kernel_isa::scalar, kernel_isa::sse2, kernel_isa::avx2, kernel_isa::avx512 };
+
+	struct options
+	{
+		uint64_t generations_ = 1000;
+		std::vector<size_t> sizes_ = { 256, 1024, 4096 };
+		std::vector<size_t> threads_;
+		std::vector<kernel_isa> kernels_;
+		std::vector<std::string> engines_ = { "grid", "chunk_map", "hashlife" };
+		std::vector<std::string> workloads_;
+		std::vector<std::string> patterns_;
+		Rule rule_ = rule_conway;
+		uint64_t census_soups_ = 0;
+		uint64_t seed_ = 1;
+		std::string census_file_;
+	};
+
+	std::vector<std::string> split(const char* list)
+	{
+		std::vector<std::string> items;
+		std::string item;
+		for (const char* c = list; ; ++c) {
+			if (*c == ',' || *c == '\0') {
+				if (!item.empty()) items.push_back(item);
+				item.clear();
+				if (*c == '\0') return items;
+			}
+			else item += *c;
+		}
+	}
+
+	bool contains(const std::vector<std::string>& items, const char* name)
+	{
+		for (const std::string& item : items) {
+			if (item == name) return true;
+		}
+		return false;
+	}
+
+	[[noreturn]] void usage_error(const char* message, const char* argument)
+	{
+		fprintf(stderr, "bench: %s '%s'\n", message, argument);
+		exit(2);
+	}
+
+	options parse_options(int argc, char** argv)
+	{
+		options parsed;
+		for (int i = 1; i < argc; ++i) {
+			const char* flag = argv[i];
+			if (i + 1 >= argc) usage_error("missing value for", flag);
+			const char* value = argv[++i];
+			if (strcmp(flag, "--generations") == 0) {
+				parsed.generations_ = strtoull(value, nullptr, 10);
+			}
+			else if (strcmp(flag, "--sizes") == 0 || strcmp(flag, "--threads") == 0) {
+				std::vector<size_t>& numbers = flag[2] == 's' ? parsed.sizes_ : parsed.threads_;
+				numbers.clear();
+				for (const std::string& item : split(value))
+					numbers.push_back(strtoull(item.c_str(), nullptr, 10));
+			}
+			else if (strcmp(flag, "--kernels") == 0) {
+				for (const std::string& item : split(value)) {
+					bool known = false;
+					for (kernel_isa isa : all_kernels) {
+						if (item == kernel_isa_name(isa)) { parsed.kernels_.push_back(isa); known = true; }
+					}
+					if (!known) usage_error("unknown kernel", item.c_str());
+				}
+			}
+			else if (strcmp(flag, "--engines") == 0) {
+				parsed.engines_ = split(value);
+				for (const std::string& item : parsed.engines_) {
+					bool known = false;
+					for (const char* name : engine_names) known |= item == name;
+					if (!known) usage_error("unknown engine", item.c_str());
+				}
+			}
+			else if (strcmp(flag, "--workloads") == 0) {
+				parsed.workloads_ = split(value);
+				for (const std::string& item : parsed.workloads_) {
+					bool known = false;
+					for (const workload& w : workloads) known |= item == w.name_;
+					if (!known) usage_error("unknown workload", item.c_str());
+				}
+			}
+			else if (strcmp(flag, "--pattern") == 0) {
+				parsed.patterns_.push_back(value);
+			}
+			else if (strcmp(flag, "--census") == 0) {
+				parsed.census_soups_ = strtoull(value, nullptr, 10);
+			}
+			else if (strcmp(flag, "--seed") == 0) {
+				parsed.seed_ = strtoull(value, nullptr, 10);
+			}
+			else if (strcmp(flag, "--census-file") == 0) {
+				parsed.census_file_ = value;
+			}
+			else if (strcmp(flag, "--rule") == 0) {
+				if (!rule_parse(value, &parsed.rule_)) usage_error("invalid rule", value);
+			}
+			else usage_error("unknown option", flag);
+		}
+
+		// By default: one thread and every thread, on the fastest kernel the CPU has.
+		if (parsed.threads_.empty()) {
+			parsed.threads_.push_back(1);
+			size_t hardware = std::thread::hardware_concurrency();
+			if (hardware > 1) parsed.threads_.push_back(hardware);
+		}
+		if (parsed.kernels_.empty()) parsed.kernels_.push_back(kernel_isa_detect());
+		return parsed;
+	}
+
+	// Calls write_run(x, y, length) for every run of live cells of w on a size by
+	// size board, with patterns in the centre.
+	template <typename write_run_type>
+	void place(const workload& w, size_t size, uint64_t seed, write_run_type&& write_run)
+	{
+		const int64_t centre = static_cast<int64_t>(size / 2);
+		if (w.path_ != nullptr) {
+			// The first read only finds the bounding box.
+			PatternInfo info;
+			if (!pattern_read(w.path_, [](int64_t, int64_t, uint64_t) {}, &info)) usage_error("can not read pattern", w.path_);
+			int64_t x = centre - (info.min_x_ + info.max_x_) / 2;
+			int64_t y = centre - (info.min_y_ + info.max_y_) / 2;
+			pattern_read(w.path_, [&](int64_t run_x, int64_t run_y, uint64_t length) { write_run(x + run_x, y + run_y, length); }, &info);
+			return;
+		}
+
+		if (w.cells_ == nullptr) {
+			std::mt19937_64 random(seed);
+			for (size_t y = 0; y < size; ++y) {
+				for (size_t x = 0; x < size; x += 64) {
+					uint64_t bits = random();
+					for (size_t bit = 0; bit < 64 && x + bit < size; ++bit) {
+						if ((bits >> bit) & 1) write_run(static_cast<int64_t>(x + bit), static_cast<int64_t>(y), 1);
+					}
+				}
+			}
+			return;
+		}
+
+		int64_t x = centre, y = centre;
+		for (const char* c = w.cells_; *c != '\0'; ++c) {
+			if (*c == '\n') { x = centre; ++y; continue; }
+			if (*c == 'O') write_run(x, y, 1);
+			++x;
+		}
+	}
+
+	uint64_t grid_population(const Grid* grid)
+	{
+		uint64_t population = 0;
+		for (size_t y = 0; y < grid->height_; ++y) {
+			const uint64_t* row = grid->cells_ + y * grid->stride_;
+			for (size_t i = 0; i < grid->words_per_row_; ++i)
+				population += std::popcount(row[i]);
+		}
+		return population;
+	}
+
+	// The peak of the whole process so far. Results are printed as they come in,
+	// so the run that raised it is the first one that shows the new value.
+	uint64_t peak_rss_bytes()
+	{
+#if defined(_WIN32)
+		PROCESS_MEMORY_COUNTERS counters;
+		if (!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) return 0;
+		return counters.PeakWorkingSetSize;
+#else
+		rusage usage;
+		if (getrusage(RUSAGE_SELF, &usage) != 0) return 0;
+		return static_cast<uint64_t>(usage.ru_maxrss) * 1024;
+#endif
+	}
+
+	struct result
+	{
+		const char* workload_;
+		size_t size_;
+		const char* engine_;
+		const char* kernel_;
+		size_t threads_;
+		uint64_t generations_;
+		double seconds_;
+		uint64_t population_;
+	};
+
+	template <typename step_type>
+	double time_seconds(step_type&& step)
+	{
+		auto start = std::chrono::steady_clock::now();
+		step();
+		return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	}
+
+	void print_result(const result& r, bool first)
+	{
+		// Cells per second counts the whole board, also for the engines that only
+		// store the live area, so the numbers compare between engines.
+		double cells = static_cast<double>(r.size_) * static_cast<double>(r.size_) * static_cast<double>(r.generations_);
+		printf("%s\n    { \"workload\": \"%s\", \"size\": %zu, \"engine\": \"%s\", \"kernel\": \"%s\", \"threads\": %zu, "
+			"\"generations\": %llu, \"seconds\": %.6f, \"generations_per_second\": %.3f, \"cells_per_second\": %.6e, "
+			"\"population\": %llu, \"peak_rss_bytes\": %llu }",
+			first ? "" : ",", r.workload_, r.size_, r.engine_, r.kernel_, r.threads_,
+			static_cast<unsigned long long>(r.generations_), r.seconds_,
+			r.generations_ / r.seconds_, cells / r.seconds_,
+			static_cast<unsigned long long>(r.population_), static_cast<unsigned long long>(peak_rss_bytes()));
+		fflush(stdout);
+	}
+
+	void run_census(const options& opts)
+	{
+		CensusOptions census_options = census_default_options(opts.seed_, opts.census_soups_);
+		census_options.rule_ = opts.rule_;
+		bool first = true;
+		for (size_t threads : opts.threads_) {
+			census_options.thread_count_ = threads;
+			Census census;
+			double seconds = time_seconds([&] { census = census_run(census_options); });
+			printf("%s\n    { \"workload\": \"census\", \"engine\": \"batch\", \"kernel\": \"%s\", \"threads\": %zu, "
+				"\"soups\": %llu, \"seconds\": %.6f, \"soups_per_second\": %.3f, \"unsettled\": %llu, \"objects\": %zu, \"peak_rss_bytes\": %llu }",
+				first ? "" : ",", kernel_isa_name(grid_active_kernel()), threads,
+				static_cast<unsigned long long>(census.soup_count_), seconds, census.soup_count_ / seconds,
+				static_cast<unsigned long long>(census.unsettled_count_), census.objects_.size(),
+				static_cast<unsigned long long>(peak_rss_bytes()));
+			fflush(stdout);
+			first = false;
+			// Every thread count finds the same objects, so any run will do.
+			if (!opts.census_file_.empty() && !census_save(census, census_options, opts.census_file_.c_str()))
+				usage_error("can not write census", opts.census_file_.c_str());
+		}
+	}
+}
+
+int main(int argc, char** argv)
+{
+	const options opts = parse_options(argc, argv);
+	const uint64_t seed = 1;
+	char rule_text[rule_text_size];
+	rule_format(opts.rule_, rule_text);
+
+	printf("{\n  \"rule\": \"%s\",\n  \"detected_kernel\": \"%s\",\n  \"hardware_threads\": %u,\n  \"results\": [",
+		rule_text, kernel_isa_name(kernel_isa_detect()), std::thread::hardware_concurrency());
+
+	std::vector<workload> suite(std::begin(workloads), std::end(workloads));
+	for (const std::string& path : opts.patterns_)
+		suite.push_back({ path.c_str(), nullptr, path.c_str() });
+
+	if (opts.census_soups_ > 0) {
+		run_census(opts);
+		printf("\n  ]\n}\n");
+		return 0;
+	}
+
+	bool first = true;
+	for (const workload& w : suite) {
+		if (w.path_ == nullptr && !opts.workloads_.empty() && !contains(opts.workloads_, w.name_)) continue;
+		for (size_t size : opts.sizes_) {
+			if (contains(opts.engines_, "grid")) {
+				for (kernel_isa isa : opts.kernels_) {
+					if (isa > kernel_isa_detect()) continue;
+					grid_use_kernel(isa);
+					for (size_t threads : opts.threads_) {
+						Grid grid = grid_init(size, size);
+						grid_set_thread_count(&grid, threads);
+						grid_set_rule(&grid, opts.rule_);
+						place(w, size, seed, [&grid, size](int64_t x, int64_t y, uint64_t length) {
+							int64_t begin = std::max<int64_t>(x, 0);
+							int64_t end = std::min<int64_t>(x + static_cast<int64_t>(length), static_cast<int64_t>(size));
+							if (y >= 0 && y < static_cast<int64_t>(size) && begin < end)
+								grid_fill_run(&grid, static_cast<size_t>(begin), static_cast<size_t>(y), static_cast<size_t>(end - begin), true);
+						});
+						double seconds = time_seconds([&] { grid_next_generations(&grid, opts.generations_); });
+						print_result({ w.name_, size, "grid", kernel_isa_name(isa), threads, opts.generations_, seconds, grid_population(&grid) }, first);
+						first = false;
+						grid_free(&grid);
+					}
+				}
+			}
+
+			if (contains(opts.engines_, "chunk_map")) {
+				ChunkMap map = chunk_map_init();
+				chunk_map_set_rule(&map, opts.rule_);
+				place(w, size, seed, [&map](int64_t x, int64_t y, uint64_t length) {
+					for (uint64_t i = 0; i < length; ++i) write_cell(&map, x + static_cast<int64_t>(i), y, true);
+				});
+				double seconds = time_seconds([&] { chunk_map_next_generations(&map, opts.generations_); });
+				print_result({ w.name_, size, "chunk_map", "scalar", 1, opts.generations_, seconds, chunk_map_population(&map) }, first);
+				first = false;
+				chunk_map_free(&map);
+			}
+
+			if (contains(opts.engines_, "hashlife")) {
+				HashLife life = hashlife_init();
+				hashlife_set_rule(&life, opts.rule_);
+				place(w, size, seed, [&life](int64_t x, int64_t y, uint64_t length) {
+					for (uint64_t i = 0; i < length; ++i) write_cell(&life, x + static_cast<int64_t>(i), y, true);
+				});
+				double seconds = time_seconds([&] { hashlife_next_generations(&life, opts.generations_); });
+				print_result({ w.name_, size, "hashlife", "scalar", 1, opts.generations_, seconds, hashlife_population(&life) }, first);
+				first = false;
+				hashlife_free(&life);
+			}
+		}
+	}
+	printf("\n  ]\n}\n");
+	return 0;
+}
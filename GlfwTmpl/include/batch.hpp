@@ -0,0 +1,77 @@
+#pragma once
+
+#include <tmpl8/integers.hpp>
+#include <grid.hpp>
+#include <grid_history.hpp>
+#include <rule.hpp>
+
+/** How one universe of a batch ended. */
+typedef struct BatchResult {
+	grid_settling settling_;
+	/** The generations until the universe comes back: 1 when stable, 0 while running. */
+	uint64_t period_;
+	/** The generation it was found settled in. */
+	uint64_t generation_;
+} BatchResult;
+
+/**
+ * Many small tori of the same size, stepped together one universe per bit: a
+ * cell is words_per_cell_ words, and bit k of word w of a cell belongs to
+ * universe 64 * w + k. The kernel adds up neighbouring cells instead of
+ * neighbouring bits, so one pass of the same bitwise adders steps 64 universes
+ * per word, 512 per AVX-512 register.
+ *
+ * Every universe is checked for settling as it goes, with Brent's cycle finding:
+ * at generations that are a power of two the cells are kept as a snapshot, and
+ * a universe that comes back to its snapshot has the period since then. A
+ * settled universe keeps being stepped with the others, its result stays.
+ */
+typedef struct Batch {
+	size_t width_;
+	size_t height_;
+	size_t universe_count_;
+	size_t words_per_cell_;
+	/** Cell (x, y) is at words_per_cell_ * (y * width_ + x). */
+	uint64_t* cells_;
+	uint64_t* cells_buffer_;
+	/** The cells at snapshot_generation_. */
+	uint64_t* snapshot_;
+	uint64_t snapshot_generation_;
+	/** Per universe, one bit each like the cells: the result is known. */
+	uint64_t* settled_;
+	/** Per universe, for the last generation: it changed, and it differs from the snapshot. */
+	uint64_t* changed_;
+	uint64_t* differs_;
+	BatchResult* results_;
+	Rule rule_;
+	uint64_t generation_;
+} Batch;
+
+/**
+ * @brief  Allocates universe_count empty width by height tori, rounded up to a
+ *         multiple of 64, running Conway's Life.
+ */
+Batch batch_init(size_t width, size_t height, size_t universe_count);
+/** @brief  Frees the memory allocated by batch_init. */
+void batch_free(Batch* batch);
+/** @brief  Kills every cell and forgets every result, so the batch can take the next universes. */
+void batch_clear(Batch* batch);
+/** @brief  Changes the rule from the next generation on. */
+void batch_set_rule(Batch* batch, Rule rule);
+
+/** @brief  Returns true if the cell at (x, y) of universe is alive. */
+bool get_cell(const Batch* batch, size_t universe, size_t x, size_t y);
+/** @brief  Sets the cell at (x, y) of universe to alive or dead. */
+void write_cell(Batch* batch, size_t universe, size_t x, size_t y, bool new_value);
+/** @brief  Returns the number of live cells of universe. */
+uint64_t batch_population(const Batch* batch, size_t universe);
+/** @brief  Copies universe into the top left corner of grid, which must be at least as large. */
+void batch_copy_universe(const Batch* batch, size_t universe, Grid* grid);
+
+/** @brief  Advances every universe by one generation, and records the ones that settled. */
+void batch_next_generation(Batch* batch);
+/**
+ * @brief  Steps the batch until every universe settled, or for at most
+ *         max_generations generations. Returns true if every one settled.
+ */
+bool batch_run_until_settled(Batch* batch, uint64_t max_generations);
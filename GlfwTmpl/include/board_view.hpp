@@ -0,0 +1,59 @@
+#pragma once
+
+#include <vector>
+#include <tmpl8/integers.hpp>
+#include <grid.hpp>
+
+/** The most pixels per cell side a view zooms in to: 2^board_view_max_zoom. */
+constexpr int32_t board_view_max_zoom = 5;
+/** The most cells per pixel side a view zooms out to: 2^-board_view_min_zoom. */
+constexpr int32_t board_view_min_zoom = -30;
+
+/** The part of the board a view shows, and at what scale. Pixel row 0 shows the lowest y. */
+struct board_view
+{
+	/** The board cell at the first pixel of the view; it can lie outside the board. */
+	int64_t x_ = 0, y_ = 0;
+	/** 2^zoom_ pixels per cell side from 0 up, 2^-zoom_ cells per pixel side below 0. */
+	int32_t zoom_ = 0;
+	/** The size of the view in pixels. */
+	size_t  width_ = 0, height_ = 0;
+
+	bool operator==(const board_view&) const = default;
+};
+
+/**
+ * The part of a generation a view shows, as published for drawing. The view is
+ * split into view cells: board cells when zoomed in, one pixel for every
+ * 2^-zoom by 2^-zoom block of board cells when zoomed out. Cells outside the
+ * board are dead.
+ */
+struct board_frame
+{
+	board_view            view_;
+	uint64_t              generation_ = 0;
+	/** The view cells across and down. */
+	size_t                columns_ = 0, rows_ = 0;
+	/** Zoomed in, one bit per view cell: row r is words_per_row_ words from r * words_per_row_ on, padded with zeroes. */
+	size_t                words_per_row_ = 0;
+	std::vector<uint64_t> cells_;
+	/** Zoomed out, one byte per view cell, row by row: 0 for an empty block, 1 to 255 with the fraction of live cells. */
+	std::vector<uint8_t>  density_;
+};
+
+/**
+ * @brief  Fills frame with what view shows of grid. Costs a word per 64 view
+ *         cells zoomed in. Zoomed out, blocks of whole tiles cost a word per
+ *         view cell while the grid tracks stats (see grid_tile_sums); smaller
+ *         blocks cost a popcount per 64 board cells on screen.
+ */
+void board_frame_capture(board_frame* frame, const Grid* grid, const board_view& view);
+
+/** @brief  Returns the view of width by height pixels that shows the whole board, centred, as large as it fits. */
+board_view board_view_fit(size_t board_width, size_t board_height, size_t width, size_t height);
+/** @brief  Returns view zoomed in by steps powers of two, or out for negative steps, around its centre. */
+board_view board_view_zoom(const board_view& view, int32_t steps);
+/** @brief  Returns view moved by dx, dy pixels. */
+board_view board_view_pan(const board_view& view, int64_t dx, int64_t dy);
+/** @brief  Returns the board cell at pixel (x, y) of view: the lowest of its block when zoomed out. */
+void board_view_cell(const board_view& view, int64_t x, int64_t y, int64_t* cell_x, int64_t* cell_y);
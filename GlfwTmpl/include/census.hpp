@@ -0,0 +1,62 @@
+#pragma once
+
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+#include <tmpl8/integers.hpp>
+#include <rule.hpp>
+
+/** What a census runs. */
+typedef struct CensusOptions {
+	/** Soup n of a run is the same for the same seed, whatever the thread count. */
+	uint64_t seed_;
+	uint64_t soup_count_;
+	/** 0 uses every hardware thread. */
+	size_t thread_count_;
+	Rule rule_;
+	/** The soups are soup_size_ squares in the centre of universe_size_ tori. */
+	size_t soup_size_;
+	/**
+	 * Large enough that most ash settles before what flies off comes around
+	 * the torus. What does come around can still hit the ash, as on any finite
+	 * universe.
+	 */
+	size_t universe_size_;
+	/** The soups stepped together in one bit-sliced Batch. */
+	size_t batch_size_;
+	/** Soups still running after this many generations count as unsettled. */
+	uint64_t max_generations_;
+} CensusOptions;
+
+/** @brief  Returns the usual census: 16x16 soups of Conway's Life in 64x64 tori, 512 at a time, on every thread. */
+CensusOptions census_default_options(uint64_t seed, uint64_t soup_count);
+
+/**
+ * The objects the soups settled into, by apgcode: "xs" with the population for
+ * still lifes, "xp" and "xq" with the period for oscillators and spaceships,
+ * then the cells of the smallest phase and orientation in extended Wechsler
+ * format, e.g. xs4_33 for the block. Ash that does not come back in isolation,
+ * or is too large to look at, counts as zz_UNKNOWN.
+ */
+typedef struct Census {
+	std::map<std::string, uint64_t> objects_;
+	uint64_t soup_count_;
+	uint64_t unsettled_count_;
+} Census;
+
+/**
+ * @brief  Runs the soups of options to the end on worker threads, splits what
+ *         is left into objects and counts them. Batches of soups are handed out
+ *         one at a time to whichever thread is free.
+ */
+Census census_run(const CensusOptions& options);
+
+/**
+ * @brief  Writes census to path as text: a few '#' lines with the options,
+ *         then one "apgcode count" line per object, the most common first.
+ */
+bool census_save(const Census& census, const CensusOptions& options, const char* path);
+
+/** @brief  Returns the apgcode of the pattern of cells, or "" if it does not come back within max_period generations. */
+std::string census_identify(const std::vector<std::pair<int64_t, int64_t>>& cells, Rule rule, uint64_t max_period);
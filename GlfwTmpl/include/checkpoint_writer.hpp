@@ -0,0 +1,72 @@
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <tmpl8/integers.hpp>
+#include <grid.hpp>
+#include <thread_pool.hpp>
+
+/**
+ * Writes snapshots of a grid on a background thread, so the grid keeps stepping
+ * while the disk is busy. checkpoint() copies the cells into a spare buffer,
+ * which costs about as much as a generation, and queues it; the writer thread
+ * saves queued checkpoints in order. When every spare buffer is still waiting
+ * for the disk, checkpoint() waits for the oldest one: a slow disk slows the
+ * simulation down instead of piling up memory.
+ */
+class checkpoint_writer final
+{
+public:
+	/**
+	 * @brief  Starts the writer thread, with room for buffer_count checkpoints in
+	 *         flight. compress writes them with grid_save_compressed_snapshot,
+	 *         split over compress_threads threads of the writer's own.
+	 */
+	checkpoint_writer(size_t buffer_count, bool compress, size_t compress_threads = 1);
+	/** @brief  Writes every queued checkpoint, then stops the writer thread. */
+	~checkpoint_writer();
+
+	/**
+	 * @brief  Copies the cells, rule, boundary and generation of grid and queues
+	 *         them to be saved to path as a snapshot. The copy is split
+	 *         over the thread pool of grid, if it has one.
+	 */
+	void checkpoint(const Grid* grid, const char* path);
+
+	/** @brief  Waits until every queued checkpoint is written. Returns false if one failed since the last flush. */
+	bool flush();
+	/** @brief  Returns false if a checkpoint failed since the last flush or check, without waiting. */
+	bool check();
+
+	checkpoint_writer           (const checkpoint_writer&) = delete;
+	checkpoint_writer& operator=(const checkpoint_writer&) = delete;
+
+private:
+	struct slot
+	{
+		/** The grid as it was, its cells pointing into cells_ and nothing else owned. */
+		Grid                  grid_;
+		std::vector<uint64_t> cells_;
+		std::string           path_;
+	};
+
+	void work();
+
+	std::vector<slot>       slots_;
+	/** Slots waiting for the writer thread, oldest first. */
+	std::deque<size_t>      queued_;
+	std::vector<size_t>     free_;
+	std::mutex              mutex_;
+	std::condition_variable slot_queued_;
+	std::condition_variable slot_freed_;
+	bool                    stopping_ = false;
+	bool                    failed_   = false;
+	bool                    compress_;
+	/** Compresses on the writer thread, and as many more as it was given: never every hardware thread behind the simulation's back. */
+	thread_pool             pool_;
+	std::thread             writer_;
+};
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <unordered_map>
+#include <vector>
+#include <tmpl8/integers.hpp>
+#include <rule.hpp>
+
+/** The width and height of a chunk in cells. A chunk row is one word. */
+constexpr int64_t chunk_map_chunk_size = 64;
+
+constexpr uint32_t chunk_map_no_chunk = ~uint32_t(0);
+
+/** A 64x64 square of cells, one word per row, bit x of row y being cell (x, y). */
+struct chunk_map_chunk
+{
+	int32_t x_, y_;
+	/** The chunks around this one, (dy + 1) * 3 + (dx + 1), or chunk_map_no_chunk. */
+	uint32_t neighbours_[9];
+	bool in_use_;
+	/** True if the chunk changed in the last generation. */
+	bool changed_;
+	bool next_changed_;
+	uint64_t rows_[2][chunk_map_chunk_size];
+};
+
+/**
+ * An unbounded universe of bit-packed chunks. Chunks are allocated when
+ * activity reaches their border and freed when they are empty again, so memory
+ * follows the live area instead of the bounding box. Chunk coordinates are
+ * 32-bit, which bounds the universe at 2^37 cells in each direction.
+ */
+typedef struct ChunkMap {
+	std::vector<chunk_map_chunk> chunks_;
+	std::vector<uint32_t> free_chunks_;
+	/** Chunk index by packed chunk coordinates. */
+	std::unordered_map<uint64_t, uint32_t> index_;
+	Rule rule_;
+	/** Which of the two row buffers of every chunk holds the current generation. */
+	uint32_t current_;
+	uint64_t generation_;
+} ChunkMap;
+
+/** @brief  Creates an empty universe running Conway's Life. */
+ChunkMap chunk_map_init();
+/** @brief  Frees every chunk of the universe. */
+void chunk_map_free(ChunkMap* map);
+/** @brief  Changes the rule from the next generation on. */
+void chunk_map_set_rule(ChunkMap* map, Rule rule);
+
+/** @brief  Returns true if the cell at (x, y) is alive. */
+bool get_cell(const ChunkMap* map, int64_t x, int64_t y);
+/** @brief  Sets the cell at (x, y) to alive or dead. */
+void write_cell(ChunkMap* map, int64_t x, int64_t y, bool new_value);
+
+/** @brief  Returns the number of live cells. */
+uint64_t chunk_map_population(const ChunkMap* map);
+/** @brief  Returns the number of allocated chunks. */
+size_t chunk_map_chunk_count(const ChunkMap* map);
+
+/** @brief  Advances the universe by one generation. */
+void chunk_map_next_generation(ChunkMap* map);
+/** @brief  Advances the universe by generation_count generations. */
+void chunk_map_next_generations(ChunkMap* map, uint64_t generation_count);
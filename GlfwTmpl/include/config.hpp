@@ -9,6 +9,39 @@ namespace config
 	/** The height of the game area in pixels. */
 	constexpr int32_t  screen_height     = 100;
 
+	/**
+	 * The size of the board in cells, 0 for the size of the game area. It is
+	 * viewed through a camera: page up and down zoom in and out by powers of
+	 * two, the arrow keys pan and home shows the whole board again.
+	 */
+	constexpr size_t   board_width       = 0;
+	constexpr size_t   board_height      = 0;
+
+	/** The amount of threads to simulate the grid on. 0 uses every hardware thread. */
+	constexpr size_t   simulation_threads = 0;
+	/** The rule to simulate, in B/S notation. */
+	constexpr char const*    simulation_rule   = "B3/S23";
+	/** Steps per second while running, on a thread of its own. 0 steps as fast as it can. */
+	constexpr double   simulation_rate   = 10.0;
+	/** Generations per step, of which only the last is drawn. '=' and '-' double and halve it while playing. */
+	constexpr uint64_t generations_per_step = 1;
+	/** If not 0: as many generations per step as take about this many milliseconds, measured as it runs, instead of generations_per_step. '=' and '-' double and halve it. */
+	constexpr double   step_budget_ms    = 0.0;
+	/** True to step powers of two generations, only from generations they divide, so oscillators keep their phase on screen. 'h' toggles it. */
+	constexpr bool     hyper_speed       = false;
+	/** An RLE, plaintext or Life 1.06 file to start with in the centre of the grid, or nullptr. Its rule wins over simulation_rule. */
+	constexpr char const*    start_pattern     = nullptr;
+	/** Without a start_pattern: the fraction of cells to start alive, at random. 0 starts empty. */
+	constexpr double   start_density     = 0.0;
+	/** The seed of the random start: the same seed gives the same board. */
+	constexpr uint64_t start_seed        = 1;
+	/** A snapshot to carry on from at start, if it holds a board of the board size, and to write back on exit; or nullptr. */
+	constexpr char const*    snapshot_path     = nullptr;
+	/** Every this many generations snapshot_path is also written in the background. 0 only writes it on exit. */
+	constexpr uint64_t checkpoint_generations = 0;
+	/** True to deflate snapshots: far smaller for sparse boards, but restored by decompressing instead of mapping. */
+	constexpr bool     compress_snapshots = false;
+
 	/** True for vsync, false for uncapped. */
 	constexpr bool     use_vsync         = true;
 	/** The amount to scale the game up with. 2^n. */
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <vector>
+#include <tmpl8/integers.hpp>
+#include <tmpl8/surface.hpp>
+#include <board_view.hpp>
+
+/**
+ * Draws published frames over a surface, keeping the frame it drew last. The
+ * next frame of the same view is compared with it a word at a time and only
+ * the view cells that differ are written, so a frame costs a pass over the
+ * packed frame plus the pixels of the cells that changed.
+ *
+ * Zoomed in a view cell is a square of pixels, alive or dead. Zoomed out it is
+ * one pixel, shaded from a quarter of the way to the alive colour for a single
+ * live cell in its block up to the alive colour for a full block.
+ */
+class frame_renderer final
+{
+public:
+	explicit frame_renderer(pixel alive_color = 0xffffffff, pixel dead_color = 0x000000);
+
+	/**
+	 * @brief  Brings screen up to date with frame and returns the pixels that
+	 *         changed, which are also marked dirty on screen. A frame of
+	 *         another view than the last one is drawn in full.
+	 */
+	tmpl8::rect draw(const board_frame& frame, tmpl8::surface& screen);
+	/** @brief  Makes the next draw() write every cell, e.g. after something else drew over the screen. */
+	void invalidate() { drawn_ = false; }
+
+	/** @brief  The pixels the last draw() changed. */
+	const tmpl8::rect& dirty() const { return dirty_; }
+
+	frame_renderer           (const frame_renderer&) = delete;
+	frame_renderer& operator=(const frame_renderer&) = delete;
+
+private:
+	tmpl8::rect draw_cells(const board_frame& frame, tmpl8::surface& screen, bool redraw);
+	tmpl8::rect draw_density(const board_frame& frame, tmpl8::surface& screen, bool redraw);
+
+	/** The colour of every density, 0 being the dead colour. */
+	pixel                 palette_[256];
+	/** False until the first draw() and after invalidate(). */
+	bool                  drawn_ = false;
+	/** The view and view cells on screen, as in board_frame. */
+	board_view            drawn_view_;
+	std::vector<uint64_t> drawn_cells_;
+	std::vector<uint8_t>  drawn_density_;
+	tmpl8::rect           dirty_;
+};
@@ -0,0 +1,181 @@
+#pragma once
+
+#include <tmpl8/integers.hpp>
+#include <rule.hpp>
+
+class thread_pool;
+struct grid_mapping;
+
+/** The height of a tile in rows. A tile is one word (64 cells) wide. */
+constexpr size_t grid_tile_size = 64;
+
+/** What the cells just outside of the grid are. */
+enum class grid_boundary
+{
+	/** Always dead. */
+	dead,
+	/** The opposite edge: the grid wraps around in both directions. */
+	torus,
+	/** The edge cell itself, as if the grid was reflected at its edges. */
+	mirror,
+	/** Wraps around left to right like a torus, and top to bottom with x flipped. */
+	klein_bottle,
+};
+
+/**
+ * What a tile holds: added up by the kernel for every tile it steps, and kept
+ * up to date as cells are written. Columns of cells cleared by writes stay set
+ * until the tile is stepped again.
+ */
+struct grid_tile_stats
+{
+	/** The rows of the tile or-ed together: bit x is set when column x has live cells. */
+	uint64_t columns_;
+	uint64_t population_;
+};
+
+/** The live cells of a grid. */
+typedef struct GridStats {
+	uint64_t population_;
+	/** The bounding box of the live cells, inclusive. min > max without live cells. */
+	size_t min_x_, min_y_, max_x_, max_y_;
+} GridStats;
+
+/**
+ * The cells of the board, one bit per cell. Cell (x, y) lives in bit x % 64 of
+ * word x / 64 of row y; every row is padded to a whole number of words and the
+ * padding bits are always zero.
+ *
+ * Rows are stride_ words apart: one halo word left of the row, the row itself
+ * and one halo word right of it. There is a halo row above the first row and
+ * below the last. Before every generation the halo is filled in from the grid
+ * according to the boundary mode, so the kernel can read all neighbours of any
+ * word without checking where it is. The left halo word keeps its cell in bit
+ * 63, the right one in bit 0.
+ *
+ * The board is split into tiles of 64x64 cells, each with the bits that changed
+ * in its last generation. Only tiles that changed, or border one that did, are
+ * stepped; every other tile is the same in both buffers already.
+ */
+typedef struct Grid {
+	size_t width_;
+	size_t height_;
+	size_t words_per_row_;
+	/** The words from one row to the next, halo words included. */
+	size_t stride_;
+	/** Points at word 0 of row 0, inside the halo. */
+	uint64_t* cells_;
+	uint64_t* cells_buffer_;
+	size_t tile_rows_;
+	/** Per tile, row by row: the cells that changed from cells_buffer_ to cells_, or-ed together. */
+	uint64_t* tile_changes_;
+	uint64_t* tile_changes_buffer_;
+	Rule rule_;
+	grid_boundary boundary_;
+	/** For wrapping boundaries: a tile on the edge changed, so every edge tile is stepped. */
+	bool border_changed_;
+	/** Per tile, row by row, while tracking stats: kept up to date by the kernel, or nullptr. */
+	grid_tile_stats* tile_stats_;
+	/** While tracking stats, the populations of larger and larger blocks of tiles: see grid_tile_sums. */
+	uint64_t* tile_sums_;
+	/** Per tile, row by row, while tracking hashes: the hash of every tile of cells_, or nullptr. */
+	uint64_t* tile_hashes_;
+	/** The generations stepped since the grid was created or restored. */
+	uint64_t generation_;
+	thread_pool* pool_;
+	/** The allocation holding the cell buffers and tile changes not mapped from a file. */
+	void* memory_;
+	/** The snapshot file mapped in as one of the cell buffers, or nullptr. */
+	grid_mapping* mapping_;
+} Grid;
+
+/** @brief  Allocates an empty (all dead) grid of width by height cells, running Conway's Life with dead boundaries. */
+Grid grid_init(size_t width, size_t height);
+/**
+ * @brief  Like grid_init, but with buffer as the current cells when it is not
+ *         nullptr: (height + 2) rows of stride words, laid out as described
+ *         above. grid_free releases mapping, which is what buffer lives in.
+ *         Returns a grid with memory_ nullptr, mapping left to the caller, if
+ *         the memory can not be allocated.
+ */
+Grid grid_init_mapped(size_t width, size_t height, uint64_t* buffer, grid_mapping* mapping);
+/** @brief  Frees the memory allocated by grid_init, and unmaps a restored snapshot. */
+void grid_free(Grid* grid);
+/**
+ * @brief  Copies the cells of a grid from grid_init_mapped into memory of its
+ *         own and releases the mapping, so that the file can be replaced: on
+ *         Windows a mapped file can not be. Does nothing for other grids.
+ */
+void grid_release_mapping(Grid* grid);
+
+/** @brief  Returns true if the cell at (x, y) is alive. */
+bool get_cell(const Grid* grid, size_t x, size_t y);
+/** @brief  Sets the cell at (x, y) to alive or dead. */
+void write_cell(Grid* grid, size_t x, size_t y, bool new_value);
+/** @brief  Sets the length cells from (x, y) to the right to alive or dead, a word at a time. */
+void grid_fill_run(Grid* grid, size_t x, size_t y, size_t length, bool new_value);
+/**
+ * @brief  Sets every cell alive with probability density, the same cells for
+ *         the same seed and size whatever the thread count. density is exact
+ *         to 32 bits: a cell is alive when a uniform 32-bit number of its own
+ *         is below density * 2^32, generated a register of words at a time
+ *         with the kernel grid_next_generation uses. Split over the thread pool
+ *         of grid, if it has one. A density that is not a number kills every cell.
+ */
+void grid_randomize(Grid* grid, double density, uint64_t seed);
+/** @brief  Makes the next generation step every tile, and adds up the tile stats again. Call after writing cells_ directly. */
+void grid_mark_changed(Grid* grid);
+
+/** @brief  Changes the rule from the next generation on. */
+void grid_set_rule(Grid* grid, Rule rule);
+/** @brief  Changes what the cells outside of the grid are from the next generation on. */
+void grid_set_boundary(Grid* grid, grid_boundary boundary);
+
+/**
+ * @brief  Starts or stops tracking the population and bounding box. Starting
+ *         adds up every tile. While it is on, the kernel adds up every tile it
+ *         steps as it writes the tile, tiles that are not stepped keep their
+ *         stats from before, and write_cell and grid_fill_run update the tiles
+ *         they write to.
+ */
+void grid_track_stats(Grid* grid, bool track);
+/**
+ * @brief  Returns the population and bounding box from the stats of the tiles.
+ *         Cells cleared since the last generation can leave the box too wide
+ *         until the next one. Scans the whole grid when not tracking stats.
+ */
+GridStats grid_stats(const Grid* grid);
+/**
+ * @brief  While tracking stats, returns the populations of the blocks of
+ *         2^level by 2^level tiles, row by row, kept up to date along with the
+ *         tiles, and sets columns to the blocks in a row. Level 0 is the tiles
+ *         themselves, in tile_stats_; levels go up until one block covers the
+ *         grid, and past that the last level is returned. Returns nullptr when
+ *         that is level 0, the tiles, or when not tracking stats.
+ */
+const uint64_t* grid_tile_sums(const Grid* grid, uint32_t level, size_t* columns);
+
+/**
+ * @brief  Starts or stops keeping a hash of every tile. While it is on, every
+ *         generation hashes the tiles it stepped that changed, or were written
+ *         to, right after stepping them.
+ */
+void grid_track_hashes(Grid* grid, bool track);
+/**
+ * @brief  Returns a 64-bit hash of the cells, equal for equal cells of equally
+ *         sized grids. Combines the tile hashes when tracking them, hashes every
+ *         tile otherwise. Cells written since the last generation count from the
+ *         next generation on.
+ */
+uint64_t grid_hash(const Grid* grid);
+
+/**
+ * @brief  Splits every generation into horizontal stripes stepped on thread_count
+ *         threads. 0 uses every hardware thread, 1 steps on the calling thread only.
+ */
+void grid_set_thread_count(Grid* grid, size_t thread_count);
+
+/** @brief  Advances the grid by one generation. */
+void grid_next_generation(Grid* grid);
+/** @brief  Advances the grid by generation_count generations. */
+void grid_next_generations(Grid* grid, size_t generation_count);
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <vector>
+#include <tmpl8/integers.hpp>
+#include <grid.hpp>
+
+/** What a board has settled into, as far as its history shows. */
+enum class grid_settling
+{
+	/** No board seen so far came back. */
+	running,
+	/** The board stays the same from one generation to the next, or is empty. */
+	stable,
+	/** The board comes back every period_ generations. */
+	oscillating,
+};
+
+typedef struct GridPeriod {
+	grid_settling settling_;
+	/** The generations until the board comes back: 1 when stable, 0 when running. */
+	uint64_t period_;
+} GridPeriod;
+
+/**
+ * Remembers the hashes of the boards a grid went through, so a board that comes
+ * back is found in one lookup. The table is direct mapped on the hash: a newer
+ * board takes the slot of an older one, so periods longer than the table may
+ * only be found once they come back a few times, and very long ones not at all.
+ * Two different boards with the same 64-bit hash would pass for an oscillator,
+ * which is not worth checking for.
+ */
+class grid_history final
+{
+public:
+	/** @brief  Makes room for table_size boards, a power of two. */
+	explicit grid_history(size_t table_size = 1024);
+
+	/**
+	 * @brief  Records the board of grid and returns what it settled into. Call
+	 *         once per generation, with tile hashes tracked so grid_hash only has
+	 *         to combine them.
+	 */
+	GridPeriod observe(const Grid* grid);
+	/** @brief  Forgets every board, e.g. before the next soup. */
+	void clear();
+
+private:
+	struct entry
+	{
+		uint64_t hash_;
+		/** The generation plus one, so that 0 is an empty slot. */
+		uint64_t generation_;
+	};
+
+	std::vector<entry> table_;
+};
+
+/**
+ * @brief  Steps grid until history finds it stable or oscillating, or for at
+ *         most max_generations generations. Tracks the tile hashes of grid from
+ *         now on. Returns what the board settled into, if it did.
+ */
+GridPeriod grid_run_until_settled(Grid* grid, grid_history* history, uint64_t max_generations);
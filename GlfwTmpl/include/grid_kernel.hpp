@@ -0,0 +1,67 @@
+#pragma once
+
+#include <grid.hpp>
+#include <batch.hpp>
+
+/** The instruction sets the generation kernel is compiled for. */
+enum class kernel_isa
+{
+	scalar,
+	sse2,
+	avx2,
+	avx512,
+};
+
+/**
+ * @brief  Computes the next generation of words [word_begin, word_end) of rows
+ *         [y_begin, y_end) of grid->cells_ into the same words of grid->cells_buffer_.
+ *         The bits that changed are or-ed into changes[word]. Unless stats is
+ *         nullptr the population and columns of the new tile are written to stats[word].
+ */
+typedef void (*grid_step_block_fn)(const Grid* grid, size_t y_begin, size_t y_end, size_t word_begin, size_t word_end, uint64_t* changes, grid_tile_stats* stats);
+
+void grid_step_block_scalar(const Grid* grid, size_t y_begin, size_t y_end, size_t word_begin, size_t word_end, uint64_t* changes, grid_tile_stats* stats);
+void grid_step_block_sse2  (const Grid* grid, size_t y_begin, size_t y_end, size_t word_begin, size_t word_end, uint64_t* changes, grid_tile_stats* stats);
+void grid_step_block_avx2  (const Grid* grid, size_t y_begin, size_t y_end, size_t word_begin, size_t word_end, uint64_t* changes, grid_tile_stats* stats);
+void grid_step_block_avx512(const Grid* grid, size_t y_begin, size_t y_end, size_t word_begin, size_t word_end, uint64_t* changes, grid_tile_stats* stats);
+
+/**
+ * @brief  Computes the next generation of every universe of batch, from
+ *         batch->cells_ into batch->cells_buffer_. Bit k of changed[word] is set
+ *         when universe 64 * word + k changed, of differs[word] when its new
+ *         cells differ from batch->snapshot_.
+ */
+typedef void (*batch_step_fn)(const Batch* batch, uint64_t* changed, uint64_t* differs);
+
+void batch_step_scalar(const Batch* batch, uint64_t* changed, uint64_t* differs);
+void batch_step_sse2  (const Batch* batch, uint64_t* changed, uint64_t* differs);
+void batch_step_avx2  (const Batch* batch, uint64_t* changed, uint64_t* differs);
+void batch_step_avx512(const Batch* batch, uint64_t* changed, uint64_t* differs);
+
+/**
+ * @brief  Fills count words with 64 random cells each, a cell alive when its
+ *         own uniform 32-bit number is below threshold, which is not 0. Word i
+ *         is the same for the same key and first_word + i on every kernel.
+ */
+typedef void (*grid_randomize_words_fn)(uint64_t* words, size_t count, uint64_t key, uint64_t first_word, uint32_t threshold);
+
+void grid_randomize_words_scalar(uint64_t* words, size_t count, uint64_t key, uint64_t first_word, uint32_t threshold);
+void grid_randomize_words_sse2  (uint64_t* words, size_t count, uint64_t key, uint64_t first_word, uint32_t threshold);
+void grid_randomize_words_avx2  (uint64_t* words, size_t count, uint64_t key, uint64_t first_word, uint32_t threshold);
+void grid_randomize_words_avx512(uint64_t* words, size_t count, uint64_t key, uint64_t first_word, uint32_t threshold);
+
+/** @brief  Returns the widest instruction set supported by both the CPU and the OS. */
+kernel_isa kernel_isa_detect();
+/** @brief  Returns a readable name for the instruction set, e.g. "avx2". */
+const char* kernel_isa_name(kernel_isa isa);
+/** @brief  Returns the kernel compiled for the instruction set. */
+grid_step_block_fn kernel_for_isa(kernel_isa isa);
+/** @brief  Returns the batch kernel compiled for the instruction set. */
+batch_step_fn batch_kernel_for_isa(kernel_isa isa);
+/** @brief  Returns the soup generator compiled for the instruction set. */
+grid_randomize_words_fn randomize_kernel_for_isa(kernel_isa isa);
+
+/** @brief  Makes grid_next_generation use the kernel for isa instead of the detected one. */
+void grid_use_kernel(kernel_isa isa);
+/** @brief  Returns the instruction set grid_next_generation currently uses. */
+kernel_isa grid_active_kernel();
@@ -0,0 +1,382 @@
+#pragma once
+
+// The generation kernel, written once and instantiated for every register type
+// (uint64_t, SSE2, AVX2, AVX-512). Each kernel_*.cpp includes this header and is
+// compiled with its own instruction set flags, so everything here lives in an
+// anonymous namespace: an AVX2 instantiation must never be merged by the linker
+// into a translation unit that may run on a CPU without AVX2.
+
+#include <grid.hpp>
+#include <batch.hpp>
+#include <rule.hpp>
+#include <bit>
+#include <utility>
+
+namespace
+{
+	/**
+	 * Describes how to move a register of reg_type from and to memory, and the
+	 * arithmetic the soup generator needs. Every register is treated as an array
+	 * of independent 64-bit lanes.
+	 */
+	template <typename reg_type>
+	struct reg_traits;
+
+	template <>
+	struct reg_traits<uint64_t>
+	{
+		static constexpr size_t words = 1;
+		static uint64_t load(const uint64_t* src) { return *src; }
+		static void store(uint64_t* dst, uint64_t value) { *dst = value; }
+		static uint64_t broadcast(uint64_t value) { return value; }
+		static uint64_t add(uint64_t a, uint64_t b) { return a + b; }
+		static uint64_t multiply(uint64_t a, uint64_t b) { return a * b; }
+		static bool all_ones(uint64_t value) { return value == ~uint64_t(0); }
+	};
+
+	inline uint64_t last_word_mask(size_t width)
+	{
+		size_t used_bits = width % 64;
+		return used_bits == 0 ? ~uint64_t(0) : (uint64_t(1) << used_bits) - 1;
+	}
+
+	// Adds three bit planes with a full adder. The 0..3 result is returned as two
+	// bit planes.
+	template <typename reg_type>
+	inline void add3(reg_type left, reg_type word, reg_type right, reg_type& sum_lo, reg_type& sum_hi)
+	{
+		reg_type half = left ^ right;
+		sum_lo = half ^ word;
+		sum_hi = (left & right) | (half & word);
+	}
+
+	// Sums every cell with its left and right neighbour. prev and next are the words
+	// one to the left and right of word, lane for lane.
+	template <typename reg_type>
+	inline void row_sum(reg_type prev, reg_type word, reg_type next, reg_type& sum_lo, reg_type& sum_hi)
+	{
+		add3((word << 1) | (prev >> 63), word, (word >> 1) | (next << 63), sum_lo, sum_hi);
+	}
+
+	// Adds the row sums of three rows with full adders, giving the population of
+	// the 3x3 block around each cell (the cell itself included) as four bit planes.
+	template <typename reg_type>
+	inline void block_sum(
+		reg_type up_lo, reg_type up_hi,
+		reg_type mid_lo, reg_type mid_hi,
+		reg_type down_lo, reg_type down_hi,
+		reg_type sum[4])
+	{
+		reg_type lo_half = up_lo ^ mid_lo;
+		sum[0] = lo_half ^ down_lo;
+		reg_type carry = (up_lo & mid_lo) | (lo_half & down_lo);
+
+		reg_type hi_half = up_hi ^ mid_hi;
+		reg_type hi_sum = hi_half ^ down_hi;
+		reg_type hi_carry = (up_hi & mid_hi) | (hi_half & down_hi);
+		sum[1] = hi_sum ^ carry;
+		reg_type carry2 = hi_sum & carry;
+		sum[2] = hi_carry ^ carry2;
+		sum[3] = hi_carry & carry2;
+	}
+
+	// All ones where the 3x3 sum is s.
+	template <uint32_t s, typename reg_type>
+	inline reg_type sum_equals(const reg_type sum[4])
+	{
+		reg_type bit0 = (s & 1) ? sum[0] : ~sum[0];
+		// 8 and 9 are the only sums with bit 3 set, and they have bits 1 and 2 clear.
+		if constexpr (s >= 8) {
+			return bit0 & sum[3];
+		}
+		else {
+			reg_type match = bit0 & ((s & 2) ? sum[1] : ~sum[1]) & ((s & 4) ? sum[2] : ~sum[2]);
+			if constexpr ((s & 6) == 0) match = match & ~sum[3];
+			return match;
+		}
+	}
+
+	/**
+	 * A rule known at compile time. born and stays are indexed by the 3x3 sum: a
+	 * dead cell with n neighbours has sum n, a live one n + 1. Only the sums the
+	 * rule acts on are decoded.
+	 */
+	template <uint32_t born, uint32_t stays>
+	struct fixed_rule
+	{
+		static_assert((born | stays) != 0, "a rule that kills every cell needs no kernel");
+	};
+
+	template <Rule rule>
+	using fixed_rule_for = fixed_rule<rule.birth_, rule.survival_ << 1>;
+
+	/** Any other rule: per 3x3 sum, all ones if a dead cell is born or a live cell stays. */
+	struct table_rule
+	{
+		uint64_t born_[10];
+		uint64_t stays_[10];
+	};
+
+	inline table_rule make_table_rule(Rule rule)
+	{
+		table_rule table;
+		for (uint32_t s = 0; s < 10; ++s) {
+			table.born_[s] = (rule.birth_ >> s) & 1 ? ~uint64_t(0) : 0;
+			table.stays_[s] = s > 0 && (rule.survival_ >> (s - 1)) & 1 ? ~uint64_t(0) : 0;
+		}
+		return table;
+	}
+
+	template <uint32_t born, uint32_t stays, uint32_t s = 0, typename reg_type>
+	inline reg_type apply_fixed_rule(reg_type self, const reg_type sum[4])
+	{
+		constexpr bool is_born = (born >> s) & 1;
+		constexpr bool is_kept = (stays >> s) & 1;
+		constexpr bool more = ((born | stays) >> (s + 1)) != 0;
+		if constexpr (!is_born && !is_kept) {
+			return apply_fixed_rule<born, stays, s + 1>(self, sum);
+		}
+		else {
+			reg_type next = sum_equals<s>(sum);
+			if constexpr (!is_born) next = next & self;
+			if constexpr (!is_kept) next = next & ~self;
+			if constexpr (more) next = next | apply_fixed_rule<born, stays, s + 1>(self, sum);
+			return next;
+		}
+	}
+
+	template <uint32_t born, uint32_t stays, typename reg_type>
+	inline reg_type apply_rule(const fixed_rule<born, stays>&, reg_type self, const reg_type sum[4])
+	{
+		return apply_fixed_rule<born, stays>(self, sum);
+	}
+
+	template <typename reg_type, uint32_t... s>
+	inline reg_type apply_table_rule(const table_rule& rule, reg_type self, const reg_type sum[4], std::integer_sequence<uint32_t, s...>)
+	{
+		using traits = reg_traits<reg_type>;
+		reg_type dead = ~self;
+		return (... | (sum_equals<s>(sum) & ((self & traits::broadcast(rule.stays_[s])) | (dead & traits::broadcast(rule.born_[s])))));
+	}
+
+	template <typename reg_type>
+	inline reg_type apply_rule(const table_rule& rule, reg_type self, const reg_type sum[4])
+	{
+		return apply_table_rule(rule, self, sum, std::make_integer_sequence<uint32_t, 10>{});
+	}
+
+	// Calls step with the fixed_rule of rule when there is a kernel specialised for
+	// it, and with a table_rule otherwise.
+	template <typename step_type>
+	inline void dispatch_rule(Rule rule, step_type&& step)
+	{
+		if (rule_equals(rule, rule_conway)) step(fixed_rule_for<rule_conway>{});
+		else if (rule_equals(rule, rule_highlife)) step(fixed_rule_for<rule_highlife>{});
+		else if (rule_equals(rule, rule_day_night)) step(fixed_rule_for<rule_day_night>{});
+		else if (rule_equals(rule, rule_seeds)) step(fixed_rule_for<rule_seeds>{});
+		else step(make_table_rule(rule));
+	}
+
+	// Computes the next generation of the cells in self from the row sums around them.
+	template <typename reg_type, typename rule_type>
+	inline reg_type next_word(const rule_type& rule, reg_type self,
+		reg_type up_lo, reg_type up_hi,
+		reg_type mid_lo, reg_type mid_hi,
+		reg_type down_lo, reg_type down_hi)
+	{
+		reg_type sum[4];
+		block_sum(up_lo, up_hi, mid_lo, mid_hi, down_lo, down_hi, sum);
+		return apply_rule(rule, self, sum);
+	}
+
+	// Steps the registers of words i.. of one row. up, mid and down may be read one
+	// word to the left and right of the register: the halo words make that safe.
+	template <typename reg_type, typename rule_type>
+	inline void step_words(const rule_type& rule, const uint64_t* up, const uint64_t* mid, const uint64_t* down, uint64_t* out, uint64_t* changes, size_t i)
+	{
+		using traits = reg_traits<reg_type>;
+		reg_type up_lo, up_hi, mid_lo, mid_hi, down_lo, down_hi;
+		row_sum(traits::load(up + i - 1), traits::load(up + i), traits::load(up + i + 1), up_lo, up_hi);
+		row_sum(traits::load(mid + i - 1), traits::load(mid + i), traits::load(mid + i + 1), mid_lo, mid_hi);
+		row_sum(traits::load(down + i - 1), traits::load(down + i), traits::load(down + i + 1), down_lo, down_hi);
+		reg_type self = traits::load(mid + i);
+		reg_type next = next_word(rule, self, up_lo, up_hi, mid_lo, mid_hi, down_lo, down_hi);
+		traits::store(out + i, next);
+		traits::store(changes + i, traits::load(changes + i) | (next ^ self));
+	}
+
+	// Adds up the tiles of a block just written, and still in the cache, a tile
+	// at a time so the sums stay in registers.
+	inline void add_tile_stats(const Grid* grid, size_t y_begin, size_t y_end, size_t word_begin, size_t word_end, grid_tile_stats* stats)
+	{
+		const size_t stride = grid->stride_;
+		const uint64_t* out = grid->cells_buffer_ + y_begin * stride;
+		for (size_t i = word_begin; i < word_end; ++i) {
+			uint64_t population = 0, columns = 0;
+			for (size_t y = 0; y < y_end - y_begin; ++y) {
+				const uint64_t word = out[y * stride + i];
+				population += std::popcount(word);
+				columns |= word;
+			}
+			stats[i] = { .columns_ = columns, .population_ = population };
+		}
+	}
+
+	// Steps words [word_begin, word_end) of rows [y_begin, y_end). Thanks to the halo
+	// rows and words around the grid every word has all eight neighbours in memory,
+	// whatever the boundary mode, so only a partly used last word needs care.
+	template <typename reg_type, typename rule_type>
+	void step_block(const rule_type& rule, const Grid* grid, size_t y_begin, size_t y_end, size_t word_begin, size_t word_end, uint64_t* changes, grid_tile_stats* stats)
+	{
+		constexpr size_t register_words = reg_traits<reg_type>::words;
+		const size_t words = grid->words_per_row_;
+		const size_t stride = grid->stride_;
+		const size_t used_bits = grid->width_ % 64;
+		const uint64_t padding_mask = last_word_mask(grid->width_);
+		// The cell right of the last column is bit 0 of the right halo word. When
+		// the last word is full that is exactly where row_sum looks for it.
+		const bool padded_last = used_bits != 0 && word_end == words;
+		const size_t full_end = padded_last ? words - 1 : word_end;
+		for (size_t y = y_begin; y < y_end; ++y) {
+			const uint64_t* mid = grid->cells_ + y * stride;
+			const uint64_t* up = mid - stride;
+			const uint64_t* down = mid + stride;
+			uint64_t* out = grid->cells_buffer_ + y * stride;
+
+			size_t i = word_begin;
+			for (; i + register_words <= full_end; i += register_words)
+				step_words<reg_type>(rule, up, mid, down, out, changes, i);
+			for (; i < full_end; ++i)
+				step_words<uint64_t>(rule, up, mid, down, out, changes, i);
+
+			if (padded_last) {
+				// Move the halo cell into the padding bit next to the last column.
+				const ptrdiff_t last = static_cast<ptrdiff_t>(words) - 1;
+				uint64_t up_lo, up_hi, mid_lo, mid_hi, down_lo, down_hi;
+				row_sum(up[last - 1], up[last] | up[words] << used_bits, uint64_t(0), up_lo, up_hi);
+				row_sum(mid[last - 1], mid[last] | mid[words] << used_bits, uint64_t(0), mid_lo, mid_hi);
+				row_sum(down[last - 1], down[last] | down[words] << used_bits, uint64_t(0), down_lo, down_hi);
+				// Cells in the padding can be born from the last column.
+				uint64_t next = next_word(rule, mid[last], up_lo, up_hi, mid_lo, mid_hi, down_lo, down_hi) & padding_mask;
+				out[last] = next;
+				changes[last] |= next ^ mid[last];
+			}
+		}
+		if (stats != nullptr) add_tile_stats(grid, y_begin, y_end, word_begin, word_end, stats);
+	}
+
+	// Steps a block with the kernel for the rule of grid.
+	template <typename reg_type>
+	void step_block(const Grid* grid, size_t y_begin, size_t y_end, size_t word_begin, size_t word_end, uint64_t* changes, grid_tile_stats* stats)
+	{
+		dispatch_rule(grid->rule_, [&](const auto& rule) {
+			step_block<reg_type>(rule, grid, y_begin, y_end, word_begin, word_end, changes, stats);
+		});
+	}
+
+	// Steps the universes in words [word, word + words of reg_type) of every cell of
+	// a batch. The neighbours of a cell are the cells around it, wrapping around
+	// the torus, so the row sums add whole cells where the grid shifts bits.
+	template <typename reg_type, typename rule_type>
+	void step_batch_lanes(const rule_type& rule, const Batch* batch, size_t word, uint64_t* changed, uint64_t* differs)
+	{
+		using traits = reg_traits<reg_type>;
+		const size_t width = batch->width_;
+		const size_t height = batch->height_;
+		const size_t words = batch->words_per_cell_;
+		const uint64_t* in = batch->cells_ + word;
+		auto cell = [in, width, words](size_t x, size_t y) { return traits::load(in + (y * width + x) * words); };
+
+		reg_type any_change = traits::broadcast(0);
+		reg_type any_difference = traits::broadcast(0);
+		for (size_t y = 0; y < height; ++y) {
+			const size_t up = (y == 0 ? height : y) - 1;
+			const size_t down = y + 1 == height ? 0 : y + 1;
+			for (size_t x = 0; x < width; ++x) {
+				const size_t left = (x == 0 ? width : x) - 1;
+				const size_t right = x + 1 == width ? 0 : x + 1;
+				reg_type up_lo, up_hi, mid_lo, mid_hi, down_lo, down_hi;
+				add3(cell(left, up), cell(x, up), cell(right, up), up_lo, up_hi);
+				add3(cell(left, y), cell(x, y), cell(right, y), mid_lo, mid_hi);
+				add3(cell(left, down), cell(x, down), cell(right, down), down_lo, down_hi);
+				reg_type self = cell(x, y);
+				reg_type next = next_word(rule, self, up_lo, up_hi, mid_lo, mid_hi, down_lo, down_hi);
+
+				const size_t offset = (y * width + x) * words + word;
+				traits::store(batch->cells_buffer_ + offset, next);
+				any_change = any_change | (next ^ self);
+				any_difference = any_difference | (next ^ traits::load(batch->snapshot_ + offset));
+			}
+		}
+		traits::store(changed + word, any_change);
+		traits::store(differs + word, any_difference);
+	}
+
+	// Steps a batch a register at a time, and the words a register does not fill up
+	// a word at a time.
+	template <typename reg_type>
+	void step_batch(const Batch* batch, uint64_t* changed, uint64_t* differs)
+	{
+		constexpr size_t register_words = reg_traits<reg_type>::words;
+		dispatch_rule(batch->rule_, [&](const auto& rule) {
+			size_t word = 0;
+			for (; word + register_words <= batch->words_per_cell_; word += register_words)
+				step_batch_lanes<reg_type>(rule, batch, word, changed, differs);
+			for (; word < batch->words_per_cell_; ++word)
+				step_batch_lanes<uint64_t>(rule, batch, word, changed, differs);
+		});
+	}
+
+	// splitmix64 of key + (counter + 1) * golden, on every lane. The counters
+	// go in premultiplied: lane by lane, x is key + (counter + 1) * golden.
+	template <typename reg_type>
+	inline reg_type mix_counter(reg_type x)
+	{
+		using traits = reg_traits<reg_type>;
+		x = traits::multiply(x ^ (x >> 30), traits::broadcast(0xbf58476d1ce4e5b9));
+		x = traits::multiply(x ^ (x >> 27), traits::broadcast(0x94d049bb133111eb));
+		return x ^ (x >> 31);
+	}
+
+	// Fills count words with 64 cells each, a cell alive when its own uniform
+	// 32-bit number is below threshold. Word i draws from the counters
+	// (first_word + i) * 32 on, so the words are the same however a row is split.
+	// The numbers are compared bit plane by bit plane, most significant first: a
+	// cell is decided by the first bit that differs from the threshold, so draws
+	// stop once every cell of the register is, which takes about eight. Bits of
+	// the threshold past its last one can not make a cell alive and are never drawn.
+	template <typename reg_type>
+	void randomize_words(uint64_t* words, size_t count, uint64_t key, uint64_t first_word, uint32_t threshold)
+	{
+		using traits = reg_traits<reg_type>;
+		constexpr size_t register_words = traits::words;
+		constexpr uint64_t golden = 0x9e3779b97f4a7c15;
+		const int bits = 32 - std::countr_zero(threshold);
+		const reg_type step = traits::broadcast(golden);
+
+		size_t i = 0;
+		for (; i + register_words <= count; i += register_words) {
+			uint64_t counters[register_words];
+			for (size_t lane = 0; lane < register_words; ++lane)
+				counters[lane] = key + ((first_word + i + lane) * 32 + 1) * golden;
+			reg_type counter = traits::load(counters);
+			reg_type alive = traits::broadcast(0), decided = traits::broadcast(0);
+			for (int bit = 0; bit < bits && !traits::all_ones(decided);) {
+				// Four planes between checks, so the loop is not a branch per draw.
+				for (const int end = bit + 4 < bits ? bit + 4 : bits; bit < end; ++bit) {
+					const reg_type random = mix_counter(counter);
+					counter = traits::add(counter, step);
+					if ((threshold >> (31 - bit)) & 1) {
+						alive = alive | (~decided & ~random);
+						decided = decided | ~random;
+					}
+					else decided = decided | random;
+				}
+			}
+			traits::store(words + i, alive);
+		}
+		if constexpr (register_words > 1) {
+			if (i < count) randomize_words<uint64_t>(words + i, count - i, key, first_word + i, threshold);
+		}
+	}
+}
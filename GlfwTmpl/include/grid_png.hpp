@@ -0,0 +1,21 @@
+#pragma once
+
+#include <tmpl8/integers.hpp>
+#include <grid.hpp>
+
+/**
+ * @brief  Writes the cells of grid to path as a 1-bit greyscale PNG, one pixel
+ *         per cell, live cells white. The packed rows are handed to the encoder
+ *         as they are, save for the bit order within a byte, and the PNG is not
+ *         converted to any other colour type.
+ */
+bool grid_save_png(const Grid* grid, const char* path);
+
+/**
+ * @brief  Sets the cells of grid to the pixels of the PNG at path, with pixel
+ *         (0, 0) at grid cell (x, y): bright pixels alive, dark ones dead.
+ *         Pixels that fall outside of the grid are dropped. A 1-bit greyscale
+ *         PNG is read without conversion; of any other one, pixels at least
+ *         half bright and half opaque are alive.
+ */
+bool grid_load_png(Grid* grid, const char* path, int64_t x, int64_t y);
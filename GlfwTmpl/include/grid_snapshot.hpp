@@ -0,0 +1,79 @@
+#pragma once
+
+#include <tmpl8/integers.hpp>
+#include <grid.hpp>
+
+/** The first bytes of every snapshot file. */
+constexpr char grid_snapshot_magic[8] = { 'L', 'I', 'F', 'E', 'S', 'N', 'A', 'P' };
+/** The version written. Snapshots of a newer version are not read. */
+constexpr uint32_t grid_snapshot_version = 2;
+/** Where the cells start in the files grid_save_snapshot writes: one page in, so they are page aligned when mapped. */
+constexpr uint32_t grid_snapshot_data_offset = 4096;
+
+/** How the cells of a snapshot are stored. */
+enum class grid_snapshot_compression : uint32_t
+{
+	/** The whole cell buffer as it is in memory, halo included, so the file can be mapped. */
+	none,
+	/**
+	 * Every tile row on its own as a zlib stream, so they can be compressed and
+	 * decompressed in parallel. A stream holds the rows of the tile row from the
+	 * left halo word of the first row, stride words per row. First comes the size
+	 * of every stream as a uint64_t, then the streams. A tile row of nothing but
+	 * zero words has no stream, and size zero.
+	 */
+	deflate,
+};
+
+/**
+ * The start of a snapshot file, little endian. The cells follow at
+ * data_offset_. The halo only has to be clean for dead boundaries; every other
+ * mode fills it in again.
+ */
+typedef struct GridSnapshotHeader {
+	char magic_[8];
+	uint32_t version_;
+	uint32_t data_offset_;
+	uint64_t width_;
+	uint64_t height_;
+	uint64_t stride_;
+	uint64_t generation_;
+	uint32_t birth_;
+	uint32_t survival_;
+	/** A grid_boundary. */
+	uint32_t boundary_;
+	/** A grid_snapshot_compression. Version 1 had no compression and kept this zero. */
+	uint32_t compression_;
+	/** The size of the cells in bytes, as stored. */
+	uint64_t data_size_;
+} GridSnapshotHeader;
+
+/**
+ * @brief  Writes the cells, rule, boundary and generation of grid to path as a
+ *         snapshot: the header page, then the cell buffer as it is in memory,
+ *         in one sequential write. The file is written next to path first and
+ *         renamed over it when complete, so path never holds half a snapshot.
+ */
+bool grid_save_snapshot(const Grid* grid, const char* path);
+
+/**
+ * @brief  Like grid_save_snapshot, but with every tile row deflated on its own.
+ *         Sparse boards shrink by orders of magnitude, but the snapshot has to be
+ *         decompressed to restore it. The tile rows are compressed on the thread
+ *         pool of grid, or on every hardware thread if it has none.
+ */
+bool grid_save_compressed_snapshot(const Grid* grid, const char* path);
+
+/**
+ * @brief  Replaces grid by the snapshot at path, keeping its thread count. An
+ *         uncompressed file is mapped copy-on-write and used as the cell buffer
+ *         as it is, so restoring copies nothing: pages are read when first
+ *         stepped, and only copied when written. A compressed one is inflated
+ *         in parallel like grid_save_compressed_snapshot compressed it. Returns
+ *         false, leaving grid alone, if the file is not a snapshot this version
+ *         can read.
+ */
+bool grid_load_snapshot(Grid* grid, const char* path);
+
+/** @brief  Unmaps a snapshot mapped by grid_load_snapshot. Called by grid_free. */
+void grid_mapping_release(grid_mapping* mapping);
@@ -0,0 +1,88 @@
+#pragma once
+
+#include <vector>
+#include <tmpl8/integers.hpp>
+#include <grid.hpp>
+#include <rule.hpp>
+
+/**
+ * A square of 2^level by 2^level cells. Level 0 nodes are single cells, every
+ * other node is made of four nodes one level down. nw holds the quadrant with
+ * the lowest x and y, se the one with the highest.
+ */
+struct hashlife_node
+{
+	uint32_t nw_, ne_, sw_, se_;
+	/** The centre half of the node after 2^result_log2_ generations, or hashlife_no_node. */
+	uint32_t result_;
+	uint16_t level_;
+	/** min(level - 2, step) of the step result_ was computed for: below that the step does not matter. */
+	uint16_t result_log2_;
+	/** The number of live cells, UINT64_MAX if there are more. */
+	uint64_t population_;
+};
+
+constexpr uint32_t hashlife_no_node = ~uint32_t(0);
+
+/**
+ * An unbounded universe stored as a quadtree in which equal squares are the
+ * same node, and in which every node remembers its own future. Regular patterns
+ * can then be advanced by 2^k generations in time roughly independent of k.
+ *
+ * Cells are addressed with signed coordinates; the root covers
+ * [-2^(level - 1), 2^(level - 1)) on both axes and grows as needed.
+ */
+typedef struct HashLife {
+	std::vector<hashlife_node> nodes_;
+	/** Open-addressed set of every node above level 0, by its children. */
+	std::vector<uint32_t> table_;
+	/** The empty node of every level. */
+	std::vector<uint32_t> empty_;
+	uint32_t root_;
+	/** The rule the cached results were computed for. */
+	Rule rule_;
+	/** The log2 of the step successors are computed for. */
+	uint32_t step_log2_;
+	uint64_t generation_;
+	/** The node count above which unreachable nodes are collected. */
+	size_t collect_threshold_;
+} HashLife;
+
+/** @brief  Creates an empty universe running Conway's Life. */
+HashLife hashlife_init();
+/** @brief  Creates a universe holding the cells and rule of grid, with grid cell (0, 0) at (0, 0). */
+HashLife hashlife_from_grid(const Grid* grid);
+/** @brief  Frees every node of the universe. */
+void hashlife_free(HashLife* life);
+/** @brief  Changes the rule from the next generation on. */
+void hashlife_set_rule(HashLife* life, Rule rule);
+
+/**
+ * @brief  Replaces the universe by the one in a Golly macrocell (.mc) file,
+ *         rule and generation included. The quadtree is built as it is read,
+ *         so the size of the pattern does not matter, only its node count.
+ *         Returns false, leaving life alone, if the file can not be read, is
+ *         not a two state macrocell file or has a rule that is not Life-like.
+ */
+bool hashlife_read_macrocell(HashLife* life, const char* path);
+/** @brief  Writes the universe as a macrocell file, every shared node once. */
+bool hashlife_write_macrocell(const HashLife* life, const char* path);
+
+/** @brief  Returns true if the cell at (x, y) is alive. */
+bool get_cell(const HashLife* life, int64_t x, int64_t y);
+/** @brief  Sets the cell at (x, y) to alive or dead. */
+void write_cell(HashLife* life, int64_t x, int64_t y, bool new_value);
+
+/** @brief  Returns the number of live cells, or UINT64_MAX if there are at least that many. */
+uint64_t hashlife_population(const HashLife* life);
+
+/** @brief  Advances the universe by one generation. */
+void hashlife_next_generation(HashLife* life);
+/**
+ * @brief  Advances the universe by generation_count generations, one power of
+ *         two at a time. Results of nodes too small to tell two steps apart
+ *         carry over from one power to the next, and from call to call.
+ */
+void hashlife_next_generations(HashLife* life, uint64_t generation_count);
+/** @brief  Advances the universe by 2^log2_generations generations in a single step. */
+void hashlife_advance_pow2(HashLife* life, uint32_t log2_generations);
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <functional>
+#include <string>
+#include <tmpl8/integers.hpp>
+#include <grid.hpp>
+#include <rule.hpp>
+
+enum class pattern_format
+{
+	/** Run length encoded, the "x = .., y = .., rule = .." format. */
+	rle,
+	/** Plaintext (.cells): rows of '.' and 'O', '!' comments. */
+	plaintext,
+	/** Life 1.06: one "x y" line per live cell. */
+	life_106,
+};
+
+/** What a pattern file says besides its cells. */
+typedef struct PatternInfo {
+	pattern_format format_;
+	/** The bounding box of the live cells in file coordinates, inclusive. min > max without live cells. */
+	int64_t min_x_, min_y_, max_x_, max_y_;
+	uint64_t population_;
+	/** The rule as written in the file, or empty if the file has none. */
+	std::string rule_text_;
+	/** True if rule_text_ is a Life-like rule; rule_ then holds it. */
+	bool rule_valid_;
+	Rule rule_;
+} PatternInfo;
+
+/** Receives length live cells from (x, y) to the right, in file coordinates. */
+typedef std::function<void(int64_t x, int64_t y, uint64_t length)> pattern_run_fn;
+
+/**
+ * @brief  Reads an RLE, plaintext or Life 1.06 file, recognised by its content,
+ *         and calls live_run for every run of live cells. The file is streamed,
+ *         cells are never held in memory. Returns false if the file can not be
+ *         read or is not a pattern file; live_run may have been called by then.
+ */
+bool pattern_read(const char* path, const pattern_run_fn& live_run, PatternInfo* info);
+
+/**
+ * @brief  Sets the live cells of a pattern file in grid, with file coordinate
+ *         (0, 0) at grid cell (x, y). Cells that fall outside of the grid are
+ *         dropped. Leaves the rule of the grid alone.
+ */
+bool grid_load_pattern(Grid* grid, const char* path, int64_t x, int64_t y, PatternInfo* info);
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <tmpl8/integers.hpp>
+
+/**
+ * A Life-like rule. A dead cell with n live neighbours is born when bit n of
+ * birth_ is set, a live cell with n live neighbours survives when bit n of
+ * survival_ is set.
+ */
+typedef struct Rule {
+	uint32_t birth_;
+	uint32_t survival_;
+} Rule;
+
+/** B3/S23 */
+constexpr Rule rule_conway    = { .birth_ = 0b000001000, .survival_ = 0b000001100 };
+/** B36/S23 */
+constexpr Rule rule_highlife  = { .birth_ = 0b001001000, .survival_ = 0b000001100 };
+/** B3678/S34678 */
+constexpr Rule rule_day_night = { .birth_ = 0b111001000, .survival_ = 0b111011000 };
+/** B2/S */
+constexpr Rule rule_seeds     = { .birth_ = 0b000000100, .survival_ = 0 };
+
+/** The size of the longest text rule_format writes, the terminating zero included. */
+constexpr size_t rule_text_size = 22;
+
+constexpr bool rule_equals(Rule a, Rule b) {
+	return a.birth_ == b.birth_ && a.survival_ == b.survival_;
+}
+
+/**
+ * @brief  Parses a rule in B/S notation ("B36/S23", either case, the slash
+ *         optional) or in S/B notation ("23/36"). Returns false, leaving rule
+ *         alone, for anything else and for rules with B0: those would bring the
+ *         empty space around every pattern to life.
+ */
+bool rule_parse(const char* text, Rule* rule);
+/** @brief  Writes rule in B/S notation to text, which has room for rule_text_size characters. */
+void rule_format(Rule rule, char* text);
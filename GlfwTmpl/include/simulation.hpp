@@ -0,0 +1,138 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <tmpl8/integers.hpp>
+#include <board_view.hpp>
+#include <grid.hpp>
+#include <triple_buffer.hpp>
+
+/** How many generations the simulation steps at once. Only the last generation of a step is published. */
+struct step_speed
+{
+	/** Generations per step without a budget. */
+	uint64_t                  generations_ = 1;
+	/** If not zero, as many generations per step as take about this long, measured as it runs. */
+	std::chrono::microseconds budget_      = std::chrono::microseconds::zero();
+	/**
+	 * True to round the generations per step down to a power of two 2^k, and to
+	 * only step 2^k generations from a multiple of 2^k, so oscillators are
+	 * always shown in the same phases.
+	 */
+	bool                      hyper_       = false;
+};
+
+/**
+ * Steps a grid on a thread of its own, so a slow generation never holds up a
+ * frame and vsync never holds up the simulation. What the view shows of the
+ * last generation of a step is captured into a triple buffer the render loop
+ * reads without waiting, at most a few hundred times a second however fast
+ * the grid steps.
+ *
+ * Running, speed and view are handed over without waiting: the thread takes
+ * them between two steps. Anything that touches the grid goes through edit(),
+ * which runs between two steps as well. A step of many generations is taken in
+ * chunks of a few milliseconds and left off for new settings or an edit, so
+ * neither waits longer than that.
+ */
+class simulation final
+{
+public:
+	/**
+	 * @brief  Starts the thread, paused, stepping grid steps_per_second times a
+	 *         second while running, or as fast as it can for 0, and publishing
+	 *         view of it. on_step is called on the thread after every step.
+	 */
+	simulation(Grid* grid, double steps_per_second, step_speed speed, const board_view& view, std::function<void(Grid*)> on_step);
+	/** @brief  Stops the thread after the step it is taking. The grid is the caller's again. */
+	~simulation();
+
+	/** @brief  Starts or pauses stepping after the current step. A pause publishes the last generation. */
+	void set_running(bool running);
+	bool running() const { return running_; }
+	/** @brief  Steps at speed from the next step on. */
+	void set_speed(step_speed speed);
+	/** @brief  Publishes view of the grid from now on, starting after the current step. */
+	void set_view(const board_view& view);
+
+	/** @brief  Calls edit with the grid between two steps, then publishes the grid. */
+	template <typename edit_type>
+	void edit(edit_type&& edit)
+	{
+		std::unique_lock<std::mutex> lock = wait_for_grid();
+		edit(grid_);
+		publish();
+		done_with_grid(lock);
+	}
+
+	/** @brief  Makes the newest published generation frame(), without waiting. Returns false if there was none since. */
+	bool update_frame() { return frames_.update(); }
+	/** @brief  The generation update_frame() took last. Only for the render loop. */
+	const board_frame& frame() const { return frames_.front(); }
+
+	simulation           (const simulation&) = delete;
+	simulation& operator=(const simulation&) = delete;
+
+private:
+	using clock = std::chrono::steady_clock;
+
+	void work();
+	// Takes over the settings handed to set_speed, set_view and set_running, publishing if they call for it. Needs mutex_.
+	void take_settings();
+	// The generations the next step takes at speed_.
+	uint64_t step_generations() const;
+	// Captures view_ of the grid into the back frame and publishes it. Needs mutex_.
+	void publish();
+	// Takes mutex_ ahead of the simulation thread, which lets go between steps while someone waits.
+	std::unique_lock<std::mutex> wait_for_grid();
+	void done_with_grid(std::unique_lock<std::mutex>& lock);
+	// Changes settings under control_mutex_ and wakes the simulation thread to take them.
+	template <typename change_type>
+	void change_settings(change_type&& change)
+	{
+		{
+			std::lock_guard<std::mutex> lock(control_mutex_);
+			change();
+			settings_changed_ = true;
+		}
+		woken_.notify_all();
+	}
+
+	Grid*                       grid_;
+	const clock::duration       step_interval_;
+	std::function<void(Grid*)>  on_step_;
+	/** What the simulation thread steps and publishes with. */
+	step_speed                  speed_;
+	board_view                  view_;
+	/** The last step, to pace the steps of a budget. */
+	uint64_t                    last_generations_       = 1;
+	/** As measured on the last chunk of generations. */
+	double                      seconds_per_generation_ = 0;
+	/** The generations of the current step, and those of it not taken yet. */
+	uint64_t                    step_size_              = 0;
+	uint64_t                    step_left_              = 0;
+	uint64_t                    last_chunk_             = 1;
+	triple_buffer<board_frame>  frames_;
+	clock::time_point           last_publish_;
+	clock::duration             publish_cost_ = clock::duration::zero();
+	uint64_t                    published_generation_   = 0;
+	/** Guards the grid, speed_, view_ and the back frame. Held for a whole step. */
+	std::mutex                  mutex_;
+	/** Guards the settings below, the next ones for the simulation thread to take; never held for long. */
+	std::mutex                  control_mutex_;
+	step_speed                  next_speed_;
+	board_view                  next_view_;
+	bool                        speed_changed_ = false;
+	bool                        view_changed_  = false;
+	std::atomic<bool>           settings_changed_ = false;
+	std::atomic<bool>           running_  = false;
+	bool                        stopping_ = false;
+	/** Edits waiting for the grid. Changes under control_mutex_. */
+	std::atomic<size_t>         waiting_  = 0;
+	std::condition_variable     woken_;
+	std::thread                 thread_;
+};
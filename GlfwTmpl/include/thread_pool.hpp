@@ -0,0 +1,58 @@
+#pragma once
+
+#include <barrier>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <tmpl8/integers.hpp>
+
+/**
+ * A fixed set of worker threads that run the same task in lock step. The
+ * thread calling run() takes part as thread 0, so a pool of one thread does
+ * not start any workers.
+ */
+class thread_pool final
+{
+public:
+	/** @brief  Starts thread_count - 1 workers. 0 uses every hardware thread. */
+	explicit thread_pool(size_t thread_count);
+	/** @brief  Stops and joins the workers. */
+	~thread_pool();
+
+	/** @brief  Returns the number of threads taking part in run(), the caller included. */
+	size_t thread_count() const { return workers_.size() + 1; }
+
+	/**
+	 * @brief  Runs round_count rounds of task on every thread. Between two rounds
+	 *         all threads wait on a barrier, which calls round_end once on the
+	 *         last thread to arrive. Returns when the last round is done.
+	 * @param  task       Called with the index of the thread, 0 <= index < thread_count().
+	 * @param  round_end  Called once per round while every thread waits.
+	 */
+	void run(size_t round_count, const std::function<void(size_t)>& task, const std::function<void()>& round_end);
+
+	thread_pool           (const thread_pool&) = delete;
+	thread_pool& operator=(const thread_pool&) = delete;
+
+private:
+	struct round_completion
+	{
+		thread_pool* pool;
+		void operator()() noexcept { (*pool->round_end_)(); }
+	};
+
+	void work(size_t thread_index);
+	void run_rounds(size_t thread_index, size_t round_count, const std::function<void(size_t)>& task);
+
+	std::vector<std::thread>           workers_;
+	std::barrier<round_completion>     barrier_;
+	std::mutex                         mutex_;
+	std::condition_variable            job_posted_;
+	uint64_t                           job_id_      = 0;
+	bool                               stopping_    = false;
+	size_t                             round_count_ = 0;
+	const std::function<void(size_t)>* task_        = nullptr;
+	const std::function<void()>*       round_end_   = nullptr;
+};
@@ -8,6 +8,14 @@
 
 namespace tmpl8
 {
+	/** The pixels from (x1, y1) up to, but not including, (x2, y2). */
+	struct rect
+	{
+		int32_t x1 = 0, y1 = 0, x2 = 0, y2 = 0;
+
+		bool empty() const noexcept { return x1 >= x2 || y1 >= y2; }
+	};
+
 	class surface final
 	{
 	public:
@@ -34,6 +42,19 @@ namespace tmpl8
 
 		pixel operator()(int32_t x, int32_t y) const;
 
+		/**
+		 * @brief  The pixels changed since the last take_dirty(), as one rectangle.
+		 *         Every drawing function marks what it draws; writes through
+		 *         buffer() only count once passed to mark_dirty().
+		 */
+		const rect& dirty() const { return dirty_; }
+		/** @brief  Returns dirty() and starts over with nothing dirty. */
+		rect take_dirty();
+		/** @brief  Adds area, clipped to the surface, to dirty(). */
+		void mark_dirty(const rect& area);
+		/** @brief  Marks the whole surface dirty. */
+		void mark_dirty();
+
 		void save_to_file(const char* file_path) const;
 
 		void clear(pixel clear_color);
@@ -62,6 +83,7 @@ namespace tmpl8
 		int32_t                  width_;
 		int32_t                  height_;
 		int32_t                  pitch_;
+		rect                     dirty_;
 	};
 
 	template <typename t_blend_func>
@@ -89,6 +111,7 @@ namespace tmpl8
 		assert(src_y + src_height <= image.height_);
 
 		if (src_width <= 0 || src_height <= 0) return;
+		mark_dirty({ x, y, x + src_width, y + src_height });
 
 		pixel* dst = buffer_.get() + x + y * pitch_;
 		pixel* src = image.buffer_.get() + src_x + src_y * image.pitch_;
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <atomic>
+#include <tmpl8/integers.hpp>
+
+/**
+ * Hands values from one producer thread to one consumer thread without either
+ * ever waiting. The producer fills back() and publishes it; the consumer calls
+ * update() to make the newest published value its front(). Of three slots one
+ * is the producer's, one the consumer's, and the third, in the middle, holds
+ * the newest published value: publishing and updating swap a slot with it. A
+ * value published before the consumer got to it is simply replaced.
+ */
+template <typename value_type>
+class triple_buffer final
+{
+public:
+	triple_buffer() = default;
+
+	/** @brief  The slot the producer fills. Only the producer may touch it. */
+	value_type& back() { return slots_[back_]; }
+	/** @brief  Makes back() the newest value, and hands the producer another slot. */
+	void publish()
+	{
+		back_ = middle_.exchange(back_ | fresh) & index_mask;
+	}
+
+	/** @brief  Makes the newest published value front(). Returns false if there was none since the last update. */
+	bool update()
+	{
+		if ((middle_.load() & fresh) == 0) return false;
+		front_ = middle_.exchange(front_) & index_mask;
+		return true;
+	}
+	/** @brief  The slot the consumer reads. Only the consumer may touch it. */
+	const value_type& front() const { return slots_[front_]; }
+
+	triple_buffer           (const triple_buffer&) = delete;
+	triple_buffer& operator=(const triple_buffer&) = delete;
+
+private:
+	/** Set in middle_ while it holds a value the consumer has not taken yet. */
+	static constexpr uint32_t fresh      = 4;
+	static constexpr uint32_t index_mask = 3;
+
+	value_type            slots_[3];
+	uint32_t              back_   = 0;
+	uint32_t              front_  = 1;
+	std::atomic<uint32_t> middle_ = 2;
+};
@@ -0,0 +1,137 @@
+#include <batch.hpp>
+#include <grid_kernel.hpp>
+#include <bit>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+namespace
+{
+	size_t cell_words(const Batch* batch)
+	{
+		return batch->width_ * batch->height_ * batch->words_per_cell_;
+	}
+
+	void take_snapshot(Batch* batch)
+	{
+		memcpy(batch->snapshot_, batch->cells_, cell_words(batch) * sizeof(uint64_t));
+		batch->snapshot_generation_ = batch->generation_;
+	}
+
+	// Records the universes in settling that were not settled yet.
+	void settle(Batch* batch, size_t word, uint64_t settling, grid_settling how, uint64_t period)
+	{
+		batch->settled_[word] |= settling;
+		for (; settling != 0; settling &= settling - 1) {
+			BatchResult& result = batch->results_[word * 64 + std::countr_zero(settling)];
+			result = { .settling_ = how, .period_ = period, .generation_ = batch->generation_ };
+		}
+	}
+}
+
+Batch batch_init(size_t width, size_t height, size_t universe_count) {
+	assert(width > 0 && height > 0 && universe_count > 0);
+	const size_t words_per_cell = (universe_count + 63) / 64;
+	const size_t cells = width * height * words_per_cell;
+	uint64_t* memory = static_cast<uint64_t*>(calloc(3 * cells + 3 * words_per_cell, sizeof(uint64_t)));
+	BatchResult* results = static_cast<BatchResult*>(calloc(words_per_cell * 64, sizeof(BatchResult)));
+	assert(memory && results);
+	return {
+		.width_ = width,
+		.height_ = height,
+		.universe_count_ = words_per_cell * 64,
+		.words_per_cell_ = words_per_cell,
+		.cells_ = memory,
+		.cells_buffer_ = memory + cells,
+		.snapshot_ = memory + 2 * cells,
+		.snapshot_generation_ = 0,
+		.settled_ = memory + 3 * cells,
+		.changed_ = memory + 3 * cells + words_per_cell,
+		.differs_ = memory + 3 * cells + 2 * words_per_cell,
+		.results_ = results,
+		.rule_ = rule_conway,
+		.generation_ = 0,
+	};
+}
+
+void batch_free(Batch* batch) {
+	// The cell buffers swap, so the allocation starts at whichever is first.
+	free(batch->cells_ < batch->cells_buffer_ ? batch->cells_ : batch->cells_buffer_);
+	free(batch->results_);
+	batch->cells_ = batch->cells_buffer_ = batch->snapshot_ = nullptr;
+	batch->settled_ = batch->changed_ = batch->differs_ = nullptr;
+	batch->results_ = nullptr;
+}
+
+void batch_clear(Batch* batch) {
+	uint64_t* memory = batch->cells_ < batch->cells_buffer_ ? batch->cells_ : batch->cells_buffer_;
+	memset(memory, 0, (3 * cell_words(batch) + 3 * batch->words_per_cell_) * sizeof(uint64_t));
+	memset(batch->results_, 0, batch->universe_count_ * sizeof(BatchResult));
+	batch->generation_ = 0;
+	batch->snapshot_generation_ = 0;
+}
+
+void batch_set_rule(Batch* batch, Rule rule) {
+	batch->rule_ = rule;
+}
+
+bool get_cell(const Batch* batch, size_t universe, size_t x, size_t y) {
+	assert(universe < batch->universe_count_ && x < batch->width_ && y < batch->height_);
+	const uint64_t word = batch->cells_[(y * batch->width_ + x) * batch->words_per_cell_ + universe / 64];
+	return (word >> (universe % 64)) & 1;
+}
+
+void write_cell(Batch* batch, size_t universe, size_t x, size_t y, bool new_value) {
+	assert(universe < batch->universe_count_ && x < batch->width_ && y < batch->height_);
+	uint64_t& word = batch->cells_[(y * batch->width_ + x) * batch->words_per_cell_ + universe / 64];
+	uint64_t bit = uint64_t(1) << (universe % 64);
+	word = new_value ? word | bit : word & ~bit;
+}
+
+uint64_t batch_population(const Batch* batch, size_t universe) {
+	uint64_t population = 0;
+	for (size_t y = 0; y < batch->height_; ++y) {
+		for (size_t x = 0; x < batch->width_; ++x)
+			population += get_cell(batch, universe, x, y);
+	}
+	return population;
+}
+
+void batch_copy_universe(const Batch* batch, size_t universe, Grid* grid) {
+	assert(grid->width_ >= batch->width_ && grid->height_ >= batch->height_);
+	for (size_t y = 0; y < batch->height_; ++y) {
+		for (size_t x = 0; x < batch->width_; ++x)
+			write_cell(grid, x, y, get_cell(batch, universe, x, y));
+	}
+}
+
+void batch_next_generation(Batch* batch) {
+	if (batch->generation_ == 0) take_snapshot(batch);
+	batch_kernel_for_isa(grid_active_kernel())(batch, batch->changed_, batch->differs_);
+	uint64_t* temp = batch->cells_;
+	batch->cells_ = batch->cells_buffer_;
+	batch->cells_buffer_ = temp;
+	++batch->generation_;
+
+	// A universe that did not change is stable, one that came back to the
+	// snapshot for the first time has been going round since.
+	for (size_t word = 0; word < batch->words_per_cell_; ++word) {
+		const uint64_t running = ~batch->settled_[word];
+		const uint64_t changed = batch->changed_[word];
+		settle(batch, word, running & ~changed, grid_settling::stable, 1);
+		settle(batch, word, running & changed & ~batch->differs_[word], grid_settling::oscillating, batch->generation_ - batch->snapshot_generation_);
+	}
+	if (std::has_single_bit(batch->generation_)) take_snapshot(batch);
+}
+
+bool batch_run_until_settled(Batch* batch, uint64_t max_generations) {
+	auto all_settled = [batch] {
+		for (size_t word = 0; word < batch->words_per_cell_; ++word) {
+			if (~batch->settled_[word] != 0) return false;
+		}
+		return true;
+	};
+	for (uint64_t i = 0; i < max_generations && !all_settled(); ++i)
+		batch_next_generation(batch);
+	return all_settled();
+}
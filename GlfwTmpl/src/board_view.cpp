@@ -0,0 +1,195 @@
+#include <board_view.hpp>
+#include <algorithm>
+#include <bit>
+#include <assert.h>
+
+namespace
+{
+	// The cells of row from x to x + 63, dead outside the board.
+	uint64_t cells_from(const Grid* grid, const uint64_t* row, int64_t x)
+	{
+		const int64_t index = x >> 6;
+		const int shift = static_cast<int>(x & 63);
+		auto word_at = [grid, row](int64_t i) {
+			return i < 0 || i >= static_cast<int64_t>(grid->words_per_row_) ? 0 : row[i];
+		};
+		const uint64_t low = word_at(index);
+		return shift == 0 ? low : (low >> shift) | (word_at(index + 1) << (64 - shift));
+	}
+
+	// The lowest count bits, count up to 64.
+	uint64_t low_bits(int64_t count)
+	{
+		return count >= 64 ? ~uint64_t(0) : (uint64_t(1) << count) - 1;
+	}
+
+	// The board cells a view covers across or down.
+	int64_t view_span(const board_view& view, size_t pixels)
+	{
+		return view.zoom_ >= 0 ? static_cast<int64_t>(pixels >> view.zoom_) : static_cast<int64_t>(pixels) << -view.zoom_;
+	}
+
+	void capture_cells(board_frame* frame, const Grid* grid, const board_view& view)
+	{
+		const size_t scale = size_t(1) << view.zoom_;
+		frame->columns_ = (view.width_ + scale - 1) / scale;
+		frame->rows_ = (view.height_ + scale - 1) / scale;
+		frame->words_per_row_ = (frame->columns_ + 63) / 64;
+		frame->cells_.assign(frame->words_per_row_ * frame->rows_, 0);
+		frame->density_.clear();
+
+		const uint64_t last_mask = low_bits(frame->columns_ % 64 == 0 ? 64 : frame->columns_ % 64);
+		for (size_t r = 0; r < frame->rows_; ++r) {
+			const int64_t y = view.y_ + static_cast<int64_t>(r);
+			if (y < 0 || y >= static_cast<int64_t>(grid->height_)) continue;
+			const uint64_t* row = grid->cells_ + y * grid->stride_;
+			uint64_t* out = frame->cells_.data() + r * frame->words_per_row_;
+			for (size_t i = 0; i < frame->words_per_row_; ++i)
+				out[i] = cells_from(grid, row, view.x_ + static_cast<int64_t>(i * 64));
+			out[frame->words_per_row_ - 1] &= last_mask;
+		}
+	}
+
+	void capture_density(board_frame* frame, const Grid* grid, const board_view& view)
+	{
+		// Per view column, the live cells of its block in the block row so far; kept to save allocating it every frame.
+		thread_local std::vector<uint64_t> populations;
+		const int64_t block = int64_t(1) << -view.zoom_;
+		frame->columns_ = view.width_;
+		frame->rows_ = view.height_;
+		frame->words_per_row_ = 0;
+		frame->cells_.clear();
+		frame->density_.assign(frame->columns_ * frame->rows_, 0);
+
+		const int64_t width = static_cast<int64_t>(grid->width_);
+		const int64_t height = static_cast<int64_t>(grid->height_);
+		// Only the view cells over the board are counted.
+		const int64_t first_column = std::clamp<int64_t>(-view.x_ / block, 0, frame->columns_);
+		const int64_t end_column = std::clamp<int64_t>((width - view.x_ + block - 1) / block, first_column, frame->columns_);
+		const int64_t first_row = std::clamp<int64_t>(-view.y_ / block, 0, frame->rows_);
+		const int64_t end_row = std::clamp<int64_t>((height - view.y_ + block - 1) / block, first_row, frame->rows_);
+		const double scale = 254.0 / (static_cast<double>(block) * static_cast<double>(block));
+		// Blocks narrower than a word are counted a word at a time: a word holds the same blocks in every row.
+		const int64_t blocks_per_word = std::max<int64_t>(64 / block, 1);
+		const int64_t first_word = first_column / blocks_per_word;
+		const int64_t end_word = (end_column + blocks_per_word - 1) / blocks_per_word;
+		populations.assign(end_word * blocks_per_word, 0);
+		// Blocks of whole tiles, starting on a block, are a population the grid keeps per tile or per block of tiles.
+		const bool whole_tiles = block >= static_cast<int64_t>(grid_tile_size) && grid->tile_stats_ != nullptr &&
+			(view.x_ & (block - 1)) == 0 && (view.y_ & (block - 1)) == 0;
+		const uint32_t level = static_cast<uint32_t>(std::countr_zero(static_cast<uint64_t>(block / static_cast<int64_t>(grid_tile_size))));
+		size_t sum_columns = grid->words_per_row_;
+		const uint64_t* sums = whole_tiles ? grid_tile_sums(grid, level, &sum_columns) : nullptr;
+		// A tile is a word across and grid_tile_size rows down.
+		const int x_shift = 6 + static_cast<int>(level), y_shift = std::countr_zero(grid_tile_size) + static_cast<int>(level);
+		for (int64_t r = first_row; r < end_row && whole_tiles; ++r) {
+			uint8_t* out = frame->density_.data() + r * frame->columns_;
+			// On the board, so not negative.
+			const size_t block_y = static_cast<size_t>((view.y_ + r * block) >> y_shift);
+			for (int64_t c = first_column; c < end_column; ++c) {
+				const size_t block_x = static_cast<size_t>((view.x_ + c * block) >> x_shift);
+				const uint64_t population = sums == nullptr ? grid->tile_stats_[block_y * sum_columns + block_x].population_ : sums[block_y * sum_columns + block_x];
+				if (population != 0) out[c] = static_cast<uint8_t>(1 + std::min(254.0, population * scale));
+			}
+		}
+		for (int64_t r = first_row; r < end_row && !whole_tiles; ++r) {
+			std::fill(populations.begin(), populations.end(), 0);
+			const int64_t y_begin = std::max<int64_t>(view.y_ + r * block, 0);
+			const int64_t y_end = std::min<int64_t>(view.y_ + (r + 1) * block, height);
+			for (int64_t y = y_begin; y < y_end; ++y) {
+				const uint64_t* row = grid->cells_ + y * grid->stride_;
+				if (block >= 64) {
+					for (int64_t c = first_column; c < end_column; ++c) {
+						const int64_t x_begin = std::max<int64_t>(view.x_ + c * block, 0);
+						const int64_t x_end = std::min<int64_t>(view.x_ + (c + 1) * block, width);
+						for (int64_t x = x_begin; x < x_end; x += 64)
+							populations[c] += std::popcount(cells_from(grid, row, x) & low_bits(x_end - x));
+					}
+					continue;
+				}
+				for (int64_t i = first_word; i < end_word; ++i) {
+					const uint64_t word = cells_from(grid, row, view.x_ + i * 64);
+					if (word == 0) continue;
+					uint64_t* out = populations.data() + i * blocks_per_word;
+					for (int64_t j = 0; j < blocks_per_word; ++j)
+						out[j] += std::popcount((word >> (j * block)) & low_bits(block));
+				}
+			}
+			uint8_t* out = frame->density_.data() + r * frame->columns_;
+			for (int64_t c = first_column; c < end_column; ++c) {
+				const uint64_t population = populations[c];
+				// Any live cell shows, however large the block.
+				if (population != 0) out[c] = static_cast<uint8_t>(1 + std::min(254.0, population * scale));
+			}
+		}
+	}
+
+	// Zoomed out, starts the view on a block: every pixel then shows the same block as the view pans.
+	board_view align_view(board_view view)
+	{
+		if (view.zoom_ < 0) {
+			const int64_t block = int64_t(1) << -view.zoom_;
+			view.x_ &= ~(block - 1);
+			view.y_ &= ~(block - 1);
+		}
+		return view;
+	}
+}
+
+void board_frame_capture(board_frame* frame, const Grid* grid, const board_view& view)
+{
+	assert(view.zoom_ >= board_view_min_zoom && view.zoom_ <= board_view_max_zoom);
+	frame->view_ = view;
+	frame->generation_ = grid->generation_;
+	if (view.zoom_ >= 0) capture_cells(frame, grid, view);
+	else capture_density(frame, grid, view);
+}
+
+board_view board_view_fit(size_t board_width, size_t board_height, size_t width, size_t height)
+{
+	board_view view;
+	view.width_ = width;
+	view.height_ = height;
+	// The closest zoom at which the board fits.
+	for (view.zoom_ = board_view_max_zoom; view.zoom_ > board_view_min_zoom; --view.zoom_) {
+		if (view_span(view, width) >= static_cast<int64_t>(board_width) && view_span(view, height) >= static_cast<int64_t>(board_height))
+			break;
+	}
+	view.x_ = static_cast<int64_t>(board_width / 2) - view_span(view, width) / 2;
+	view.y_ = static_cast<int64_t>(board_height / 2) - view_span(view, height) / 2;
+	return align_view(view);
+}
+
+board_view board_view_zoom(const board_view& view, int32_t steps)
+{
+	board_view zoomed = view;
+	zoomed.zoom_ = std::clamp(view.zoom_ + steps, board_view_min_zoom, board_view_max_zoom);
+	const int64_t centre_x = view.x_ + view_span(view, view.width_) / 2;
+	const int64_t centre_y = view.y_ + view_span(view, view.height_) / 2;
+	zoomed.x_ = centre_x - view_span(zoomed, zoomed.width_) / 2;
+	zoomed.y_ = centre_y - view_span(zoomed, zoomed.height_) / 2;
+	return align_view(zoomed);
+}
+
+board_view board_view_pan(const board_view& view, int64_t dx, int64_t dy)
+{
+	board_view panned = view;
+	if (view.zoom_ >= 0) {
+		panned.x_ += dx >> view.zoom_;
+		panned.y_ += dy >> view.zoom_;
+	}
+	else {
+		panned.x_ += dx * (int64_t(1) << -view.zoom_);
+		panned.y_ += dy * (int64_t(1) << -view.zoom_);
+	}
+	return panned;
+}
+
+void board_view_cell(const board_view& view, int64_t x, int64_t y, int64_t* cell_x, int64_t* cell_y)
+{
+	board_view origin = view;
+	origin.x_ = origin.y_ = 0;
+	const board_view moved = board_view_pan(origin, x, y);
+	*cell_x = view.x_ + moved.x_;
+	*cell_y = view.y_ + moved.y_;
+}
@@ -0,0 +1,369 @@
+#include <census.hpp>
+#include <batch.hpp>
+#include <grid.hpp>
+#include <grid_history.hpp>
+#include <thread_pool.hpp>
+#include <algorithm>
+#include <atomic>
+#include <unordered_map>
+#include <bit>
+#include <stdio.h>
+#include <assert.h>
+
+namespace
+{
+	using cell_list = std::vector<std::pair<int64_t, int64_t>>;
+
+	constexpr char wechsler_digits[] = "0123456789abcdefghijklmnopqrstuvwxyz";
+
+	// The splitmix64 finaliser.
+	uint64_t mix(uint64_t x)
+	{
+		x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9;
+		x = (x ^ (x >> 27)) * 0x94d049bb133111eb;
+		return x ^ (x >> 31);
+	}
+
+	// The cells of row y of soup n of a run: a function of the seed, n and y only,
+	// so it does not matter which thread builds which soup.
+	uint64_t soup_row(uint64_t seed, uint64_t soup, size_t y)
+	{
+		return mix(mix(seed) ^ (soup * 64 + y));
+	}
+
+	/** A pattern moved so that its bounding box starts at (0, 0), its cells sorted. */
+	struct shape
+	{
+		int64_t x_, y_;
+		int64_t width_, height_;
+		cell_list cells_;
+	};
+
+	shape normalise(cell_list cells)
+	{
+		int64_t min_x = INT64_MAX, min_y = INT64_MAX, max_x = INT64_MIN, max_y = INT64_MIN;
+		for (auto [x, y] : cells) {
+			min_x = std::min(min_x, x);
+			min_y = std::min(min_y, y);
+			max_x = std::max(max_x, x);
+			max_y = std::max(max_y, y);
+		}
+		for (auto& [x, y] : cells) {
+			x -= min_x;
+			y -= min_y;
+		}
+		std::sort(cells.begin(), cells.end());
+		return { min_x, min_y, max_x - min_x + 1, max_y - min_y + 1, std::move(cells) };
+	}
+
+	// Strips of five rows, one digit per column with bit y for row y of the strip,
+	// separated by z. Trailing empty columns are left out, and runs of them in
+	// between are written as w (two), x (three) or y plus a digit (4 to 39).
+	std::string wechsler(const shape& pattern)
+	{
+		std::string code;
+		std::vector<uint32_t> columns;
+		for (int64_t strip = 0; strip * 5 < pattern.height_; ++strip) {
+			columns.assign(pattern.width_, 0);
+			for (auto [x, y] : pattern.cells_) {
+				if (y / 5 == strip) columns[x] |= uint32_t(1) << (y % 5);
+			}
+			while (!columns.empty() && columns.back() == 0) columns.pop_back();
+
+			if (strip > 0) code += 'z';
+			size_t zeros = 0;
+			for (uint32_t column : columns) {
+				if (column == 0) {
+					++zeros;
+					continue;
+				}
+				while (zeros >= 4) {
+					size_t run = std::min<size_t>(zeros, 39);
+					code += 'y';
+					code += wechsler_digits[run - 4];
+					zeros -= run;
+				}
+				if (zeros == 3) code += 'x';
+				if (zeros == 2) code += 'w';
+				if (zeros == 1) code += '0';
+				zeros = 0;
+				code += wechsler_digits[column];
+			}
+		}
+		return code;
+	}
+
+	// The shortest code of any phase in any of the eight orientations, the first
+	// in ASCII order among those.
+	std::string canonical_code(const std::vector<cell_list>& phases)
+	{
+		std::string best;
+		for (const cell_list& phase : phases) {
+			for (int orientation = 0; orientation < 8; ++orientation) {
+				cell_list turned;
+				turned.reserve(phase.size());
+				for (auto [x, y] : phase) {
+					if (orientation & 4) std::swap(x, y);
+					turned.emplace_back(orientation & 1 ? -x : x, orientation & 2 ? -y : y);
+				}
+				std::string code = wechsler(normalise(std::move(turned)));
+				if (best.empty() || code.size() < best.size() || (code.size() == best.size() && code < best))
+					best = std::move(code);
+			}
+		}
+		return best;
+	}
+
+	cell_list live_cells(const Grid* grid)
+	{
+		cell_list cells;
+		for (size_t y = 0; y < grid->height_; ++y) {
+			const uint64_t* row = grid->cells_ + y * grid->stride_;
+			for (size_t i = 0; i < grid->words_per_row_; ++i) {
+				for (uint64_t word = row[i]; word != 0; word &= word - 1)
+					cells.emplace_back(static_cast<int64_t>(i * 64 + std::countr_zero(word)), static_cast<int64_t>(y));
+			}
+		}
+		return cells;
+	}
+
+	// The index of cell (x, y) of a size by size torus, for x and y anywhere.
+	size_t torus_index(int64_t x, int64_t y, size_t size)
+	{
+		const int64_t side = static_cast<int64_t>(size);
+		return static_cast<size_t>(((y % side + side) % side) * side + (x % side + side) % side);
+	}
+
+	// Splits the live cells of a size by size torus into groups of touching cells,
+	// diagonals included. The coordinates of a group are unwrapped, so a group
+	// across the edge of the torus stays in one piece.
+	std::vector<cell_list> components(const std::vector<uint8_t>& alive, size_t size)
+	{
+		const int64_t side = static_cast<int64_t>(size);
+		auto index = [size](int64_t x, int64_t y) { return torus_index(x, y, size); };
+
+		std::vector<cell_list> groups;
+		std::vector<uint8_t> seen(alive.size(), 0);
+		cell_list pending;
+		for (int64_t y = 0; y < side; ++y) {
+			for (int64_t x = 0; x < side; ++x) {
+				if (!alive[index(x, y)] || seen[index(x, y)]) continue;
+				cell_list group;
+				seen[index(x, y)] = 1;
+				pending.emplace_back(x, y);
+				while (!pending.empty()) {
+					auto [cx, cy] = pending.back();
+					pending.pop_back();
+					group.emplace_back(cx, cy);
+					for (int64_t dy = -1; dy <= 1; ++dy) {
+						for (int64_t dx = -1; dx <= 1; ++dx) {
+							size_t i = index(cx + dx, cy + dy);
+							if (!alive[i] || seen[i]) continue;
+							seen[i] = 1;
+							pending.emplace_back(cx + dx, cy + dy);
+						}
+					}
+				}
+				groups.push_back(std::move(group));
+			}
+		}
+		return groups;
+	}
+
+	// The generations an object may take to come back, and the ash a torus may
+	// take to settle once its spaceships are gone.
+	constexpr uint64_t max_object_period = 64;
+	constexpr uint64_t max_ash_generations = 4096;
+
+	void count(Census* census, const std::string& apgcode)
+	{
+		++census->objects_[apgcode.empty() ? "zz_UNKNOWN" : apgcode];
+	}
+
+	// Most of the ash is the same few objects in the same few orientations, so
+	// every thread remembers what it identified by the code of what it was given.
+	using identified_map = std::unordered_map<std::string, std::string>;
+
+	const std::string& identify(const cell_list& cells, Rule rule, identified_map* identified)
+	{
+		std::string as_found = wechsler(normalise(cells));
+		auto known = identified->find(as_found);
+		if (known != identified->end()) return known->second;
+		return identified->emplace(std::move(as_found), census_identify(cells, rule, max_object_period)).first->second;
+	}
+
+	// Counts the objects universe settled into. Spaceships are found, and taken
+	// out, one piece at a time. What is left is stepped through its period on a
+	// torus of its own, and split along the cells it ever covers, so that an
+	// oscillator that falls apart into pieces in some phase stays one object.
+	void take_census(const Batch* batch, size_t universe, Rule rule, Census* census, identified_map* identified)
+	{
+		const BatchResult& result = batch->results_[universe];
+		if (result.settling_ == grid_settling::running) {
+			++census->unsettled_count_;
+			return;
+		}
+
+		const size_t size = batch->width_;
+		std::vector<uint8_t> alive(size * size);
+		for (size_t y = 0; y < size; ++y) {
+			for (size_t x = 0; x < size; ++x)
+				alive[y * size + x] = get_cell(batch, universe, x, y);
+		}
+
+		std::vector<uint8_t> covered = alive;
+		if (result.settling_ == grid_settling::oscillating) {
+			for (const cell_list& group : components(alive, size)) {
+				const std::string& apgcode = identify(group, rule, identified);
+				if (apgcode.compare(0, 2, "xq") != 0) continue;
+				count(census, apgcode);
+				for (auto [x, y] : group)
+					alive[torus_index(x, y, size)] = 0;
+			}
+
+			Grid ash = grid_init(size, size);
+			grid_set_boundary(&ash, grid_boundary::torus);
+			grid_set_rule(&ash, rule);
+			for (size_t i = 0; i < alive.size(); ++i) {
+				if (alive[i]) write_cell(&ash, i % size, i / size, true);
+			}
+			grid_history history;
+			GridPeriod period = grid_run_until_settled(&ash, &history, max_ash_generations);
+			if (period.settling_ == grid_settling::running) {
+				count(census, "");
+				grid_free(&ash);
+				return;
+			}
+			// A whole period on, the ash is back where it started.
+			std::fill(covered.begin(), covered.end(), 0);
+			for (uint64_t i = 0; i < period.period_; ++i) {
+				grid_next_generation(&ash);
+				for (auto [x, y] : live_cells(&ash))
+					covered[y * size + x] = 1;
+			}
+			std::fill(alive.begin(), alive.end(), 0);
+			for (auto [x, y] : live_cells(&ash))
+				alive[y * size + x] = 1;
+			grid_free(&ash);
+		}
+
+		for (const cell_list& group : components(covered, size)) {
+			cell_list object;
+			for (auto [x, y] : group) {
+				if (alive[torus_index(x, y, size)]) object.emplace_back(x, y);
+			}
+			if (!object.empty()) count(census, identify(object, rule, identified));
+		}
+	}
+}
+
+CensusOptions census_default_options(uint64_t seed, uint64_t soup_count) {
+	return {
+		.seed_ = seed,
+		.soup_count_ = soup_count,
+		.thread_count_ = 0,
+		.rule_ = rule_conway,
+		.soup_size_ = 16,
+		.universe_size_ = 64,
+		.batch_size_ = 512,
+		.max_generations_ = 1 << 15,
+	};
+}
+
+std::string census_identify(const cell_list& cells, Rule rule, uint64_t max_period) {
+	if (cells.empty()) return "";
+	const shape start = normalise(cells);
+
+	// Room for the object to move one cell per generation in any direction.
+	const int64_t margin = static_cast<int64_t>(max_period) + 2;
+	const int64_t side = std::max(start.width_, start.height_) + 2 * margin;
+	Grid grid = grid_init(static_cast<size_t>(side), static_cast<size_t>(side));
+	grid_set_rule(&grid, rule);
+	for (auto [x, y] : start.cells_)
+		write_cell(&grid, static_cast<size_t>(x + margin), static_cast<size_t>(y + margin), true);
+
+	std::string apgcode;
+	std::vector<cell_list> phases = { start.cells_ };
+	for (uint64_t period = 1; period <= max_period; ++period) {
+		grid_next_generation(&grid);
+		cell_list now = live_cells(&grid);
+		if (now.empty()) break;
+		shape moved = normalise(now);
+		if (moved.cells_ == start.cells_) {
+			const bool still = moved.x_ == margin && moved.y_ == margin;
+			apgcode = period == 1 && still ? "xs" + std::to_string(start.cells_.size()) :
+				(still ? "xp" : "xq") + std::to_string(period);
+			apgcode += '_';
+			apgcode += canonical_code(phases);
+			break;
+		}
+		// Too close to the edge to tell what it would do next.
+		if (moved.x_ == 0 || moved.y_ == 0 || moved.x_ + moved.width_ >= side || moved.y_ + moved.height_ >= side) break;
+		phases.push_back(std::move(now));
+	}
+	grid_free(&grid);
+	return apgcode;
+}
+
+Census census_run(const CensusOptions& options) {
+	assert(options.soup_size_ <= 64 && options.soup_size_ <= options.universe_size_);
+	const uint64_t batch_size = options.batch_size_;
+	const uint64_t batch_count = (options.soup_count_ + batch_size - 1) / batch_size;
+	const size_t offset = (options.universe_size_ - options.soup_size_) / 2;
+	const uint64_t soup_mask = options.soup_size_ == 64 ? ~uint64_t(0) : (uint64_t(1) << options.soup_size_) - 1;
+
+	// Batches go to whichever thread asks first; every thread counts into its
+	// own census, and the counts add up the same whichever thread did what.
+	thread_pool pool(options.thread_count_);
+	std::vector<Census> found(pool.thread_count(), Census{ {}, 0, 0 });
+	std::atomic<uint64_t> next_batch = 0;
+	pool.run(1, [&](size_t thread) {
+		Batch batch = batch_init(options.universe_size_, options.universe_size_, batch_size);
+		batch_set_rule(&batch, options.rule_);
+		identified_map identified;
+		for (uint64_t b = next_batch++; b < batch_count; b = next_batch++) {
+			const uint64_t first_soup = b * batch_size;
+			const size_t soups = static_cast<size_t>(std::min(batch_size, options.soup_count_ - first_soup));
+			batch_clear(&batch);
+			for (size_t universe = 0; universe < soups; ++universe) {
+				for (size_t y = 0; y < options.soup_size_; ++y) {
+					uint64_t row = soup_row(options.seed_, first_soup + universe, y) & soup_mask;
+					for (; row != 0; row &= row - 1)
+						write_cell(&batch, universe, offset + std::countr_zero(row), offset + y, true);
+				}
+			}
+			batch_run_until_settled(&batch, options.max_generations_);
+			for (size_t universe = 0; universe < soups; ++universe)
+				take_census(&batch, universe, options.rule_, &found[thread], &identified);
+			found[thread].soup_count_ += soups;
+		}
+		batch_free(&batch);
+	}, [] {});
+
+	Census census = { {}, 0, 0 };
+	for (const Census& part : found) {
+		for (const auto& [apgcode, count] : part.objects_)
+			census.objects_[apgcode] += count;
+		census.soup_count_ += part.soup_count_;
+		census.unsettled_count_ += part.unsettled_count_;
+	}
+	return census;
+}
+
+bool census_save(const Census& census, const CensusOptions& options, const char* path) {
+	FILE* file = fopen(path, "w");
+	if (file == nullptr) return false;
+
+	char rule_text[rule_text_size];
+	rule_format(options.rule_, rule_text);
+	fprintf(file, "# rule %s\n# seed %llu\n# soups %llu (%zux%zu in %zux%zu tori)\n# unsettled %llu\n",
+		rule_text, static_cast<unsigned long long>(options.seed_), static_cast<unsigned long long>(census.soup_count_),
+		options.soup_size_, options.soup_size_, options.universe_size_, options.universe_size_,
+		static_cast<unsigned long long>(census.unsettled_count_));
+
+	std::vector<std::pair<std::string, uint64_t>> objects(census.objects_.begin(), census.objects_.end());
+	std::stable_sort(objects.begin(), objects.end(), [](const auto& a, const auto& b) { return a.second > b.second; });
+	for (const auto& [apgcode, count] : objects)
+		fprintf(file, "%s %llu\n", apgcode.c_str(), static_cast<unsigned long long>(count));
+	return fclose(file) == 0;
+}
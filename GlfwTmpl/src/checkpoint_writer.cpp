@@ -0,0 +1,119 @@
+#include <checkpoint_writer.hpp>
+#include <grid_snapshot.hpp>
+#include <thread_pool.hpp>
+#include <string.h>
+#include <assert.h>
+
+checkpoint_writer::checkpoint_writer(size_t buffer_count, bool compress, size_t compress_threads) :
+	slots_(buffer_count),
+	compress_(compress),
+	pool_(compress_threads)
+{
+	assert(buffer_count > 0 && compress_threads > 0);
+	for (size_t i = 0; i < buffer_count; ++i)
+		free_.push_back(i);
+	writer_ = std::thread(&checkpoint_writer::work, this);
+}
+
+checkpoint_writer::~checkpoint_writer()
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		stopping_ = true;
+	}
+	slot_queued_.notify_one();
+	writer_.join();
+}
+
+void checkpoint_writer::checkpoint(const Grid* grid, const char* path)
+{
+	size_t index;
+	{
+		std::unique_lock<std::mutex> lock(mutex_);
+		slot_freed_.wait(lock, [this] { return !free_.empty(); });
+		index = free_.back();
+		free_.pop_back();
+	}
+
+	// The slot is ours until it is queued, so the copy needs no lock.
+	slot& copy = slots_[index];
+	const size_t word_count = grid->stride_ * (grid->height_ + 2);
+	copy.cells_.resize(word_count);
+	copy.grid_ = *grid;
+	copy.grid_.cells_ = copy.cells_.data() + grid->stride_ + 1;
+	copy.grid_.cells_buffer_ = nullptr;
+	copy.grid_.tile_changes_ = nullptr;
+	copy.grid_.tile_changes_buffer_ = nullptr;
+	copy.grid_.tile_stats_ = nullptr;
+	copy.grid_.tile_sums_ = nullptr;
+	copy.grid_.tile_hashes_ = nullptr;
+	// Only the writer thread saves, on the pool of the writer.
+	copy.grid_.pool_ = &pool_;
+	copy.grid_.memory_ = nullptr;
+	copy.grid_.mapping_ = nullptr;
+	copy.path_ = path;
+
+	const uint64_t* source = grid->cells_ - grid->stride_ - 1;
+	uint64_t* destination = copy.cells_.data();
+	if (grid->pool_ == nullptr) {
+		memcpy(destination, source, word_count * sizeof(uint64_t));
+	}
+	else {
+		const size_t stripe_count = grid->pool_->thread_count();
+		grid->pool_->run(1, [=](size_t stripe) {
+			size_t begin = word_count * stripe / stripe_count;
+			size_t end = word_count * (stripe + 1) / stripe_count;
+			memcpy(destination + begin, source + begin, (end - begin) * sizeof(uint64_t));
+		}, [] {});
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		queued_.push_back(index);
+	}
+	slot_queued_.notify_one();
+}
+
+bool checkpoint_writer::flush()
+{
+	std::unique_lock<std::mutex> lock(mutex_);
+	slot_freed_.wait(lock, [this] { return free_.size() == slots_.size(); });
+	bool ok = !failed_;
+	failed_ = false;
+	return ok;
+}
+
+bool checkpoint_writer::check()
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	bool ok = !failed_;
+	failed_ = false;
+	return ok;
+}
+
+void checkpoint_writer::work()
+{
+	for (;;)
+	{
+		size_t index;
+		{
+			std::unique_lock<std::mutex> lock(mutex_);
+			slot_queued_.wait(lock, [this] { return stopping_ || !queued_.empty(); });
+			// Stopping only once the queue is empty.
+			if (queued_.empty()) return;
+			index = queued_.front();
+			queued_.pop_front();
+		}
+
+		const slot& copy = slots_[index];
+		bool ok = compress_ ?
+			grid_save_compressed_snapshot(&copy.grid_, copy.path_.c_str()) :
+			grid_save_snapshot(&copy.grid_, copy.path_.c_str());
+		{
+			std::lock_guard<std::mutex> lock(mutex_);
+			failed_ |= !ok;
+			free_.push_back(index);
+		}
+		slot_freed_.notify_all();
+	}
+}
@@ -0,0 +1,252 @@
+#include <chunk_map.hpp>
+#include <grid_kernel_impl.hpp>
+#include <bit>
+#include <assert.h>
+
+namespace
+{
+	constexpr uint32_t centre = 4;
+	const uint64_t no_rows[chunk_map_chunk_size] = {};
+
+	uint64_t chunk_key(int32_t x, int32_t y)
+	{
+		return static_cast<uint64_t>(static_cast<uint32_t>(x)) << 32 | static_cast<uint32_t>(y);
+	}
+
+	uint32_t direction(int32_t dx, int32_t dy)
+	{
+		return static_cast<uint32_t>((dy + 1) * 3 + (dx + 1));
+	}
+
+	uint32_t find_chunk(const ChunkMap* map, int32_t x, int32_t y)
+	{
+		auto found = map->index_.find(chunk_key(x, y));
+		return found == map->index_.end() ? chunk_map_no_chunk : found->second;
+	}
+
+	uint32_t allocate_chunk(ChunkMap* map, int32_t x, int32_t y)
+	{
+		uint32_t index;
+		if (!map->free_chunks_.empty()) {
+			index = map->free_chunks_.back();
+			map->free_chunks_.pop_back();
+		}
+		else {
+			index = static_cast<uint32_t>(map->chunks_.size());
+			map->chunks_.emplace_back();
+		}
+
+		chunk_map_chunk& chunk = map->chunks_[index];
+		chunk = {};
+		chunk.x_ = x;
+		chunk.y_ = y;
+		chunk.in_use_ = true;
+		// Stepping a new chunk also steps its neighbours, which caused it.
+		chunk.changed_ = true;
+		map->index_.emplace(chunk_key(x, y), index);
+
+		for (int32_t dy = -1; dy <= 1; ++dy) {
+			for (int32_t dx = -1; dx <= 1; ++dx) {
+				uint32_t d = direction(dx, dy);
+				uint32_t neighbour = d == centre ? index : find_chunk(map, x + dx, y + dy);
+				map->chunks_[index].neighbours_[d] = neighbour;
+				if (neighbour != chunk_map_no_chunk)
+					map->chunks_[neighbour].neighbours_[8 - d] = index;
+			}
+		}
+		return index;
+	}
+
+	void free_chunk(ChunkMap* map, uint32_t index)
+	{
+		chunk_map_chunk& chunk = map->chunks_[index];
+		for (uint32_t d = 0; d < 9; ++d) {
+			uint32_t neighbour = chunk.neighbours_[d];
+			if (d != centre && neighbour != chunk_map_no_chunk)
+				map->chunks_[neighbour].neighbours_[8 - d] = chunk_map_no_chunk;
+		}
+		map->index_.erase(chunk_key(chunk.x_, chunk.y_));
+		chunk.in_use_ = false;
+		map->free_chunks_.push_back(index);
+	}
+
+	// Returns true if rows has live cells on the border (or corner) that faces the
+	// chunk at (dx, dy).
+	bool border_live(const uint64_t* rows, int32_t dx, int32_t dy)
+	{
+		int32_t y_begin = dy > 0 ? chunk_map_chunk_size - 1 : 0;
+		int32_t y_end = dy < 0 ? 1 : chunk_map_chunk_size;
+		uint64_t mask = dx < 0 ? uint64_t(1) : dx > 0 ? uint64_t(1) << 63 : ~uint64_t(0);
+		uint64_t live = 0;
+		for (int32_t y = y_begin; y < y_end; ++y)
+			live |= rows[y] & mask;
+		return live != 0;
+	}
+
+	bool chunk_empty(const uint64_t* rows)
+	{
+		uint64_t live = 0;
+		for (int32_t y = 0; y < chunk_map_chunk_size; ++y)
+			live |= rows[y];
+		return live == 0;
+	}
+
+	// A chunk with no changes around it is equal in both buffers already.
+	bool chunk_active(const ChunkMap* map, const chunk_map_chunk& chunk)
+	{
+		for (uint32_t neighbour : chunk.neighbours_) {
+			if (neighbour != chunk_map_no_chunk && map->chunks_[neighbour].changed_) return true;
+		}
+		return false;
+	}
+
+	template <typename rule_type>
+	void step_chunk(const rule_type& rule, ChunkMap* map, chunk_map_chunk& chunk)
+	{
+		const uint32_t current = map->current_;
+		const uint64_t* around[9];
+		for (uint32_t d = 0; d < 9; ++d) {
+			uint32_t neighbour = chunk.neighbours_[d];
+			around[d] = neighbour == chunk_map_no_chunk ? no_rows : map->chunks_[neighbour].rows_[current];
+		}
+
+		// The row sums of rows y - 1, y and y + 1, slid down one row at a time. Row -1
+		// comes from the chunks above, row 64 from the chunks below.
+		auto sum_row = [&](int32_t y, uint64_t& sum_lo, uint64_t& sum_hi) {
+			uint32_t band = y < 0 ? 0 : y >= chunk_map_chunk_size ? 6 : 3;
+			int32_t row = y & (chunk_map_chunk_size - 1);
+			row_sum(around[band][row], around[band + 1][row], around[band + 2][row], sum_lo, sum_hi);
+		};
+
+		const uint64_t* rows = around[centre];
+		uint64_t* next_rows = chunk.rows_[current ^ 1];
+		uint64_t up_lo, up_hi, mid_lo, mid_hi, down_lo, down_hi;
+		uint64_t changes = 0;
+		sum_row(-1, up_lo, up_hi);
+		sum_row(0, mid_lo, mid_hi);
+		for (int32_t y = 0; y < chunk_map_chunk_size; ++y) {
+			sum_row(y + 1, down_lo, down_hi);
+			next_rows[y] = next_word(rule, rows[y], up_lo, up_hi, mid_lo, mid_hi, down_lo, down_hi);
+			changes |= next_rows[y] ^ rows[y];
+			up_lo = mid_lo; up_hi = mid_hi;
+			mid_lo = down_lo; mid_hi = down_hi;
+		}
+		chunk.next_changed_ = changes != 0;
+	}
+}
+
+ChunkMap chunk_map_init() {
+	ChunkMap map = {
+		.chunks_ = {},
+		.free_chunks_ = {},
+		.index_ = {},
+		.rule_ = rule_conway,
+		.current_ = 0,
+		.generation_ = 0,
+	};
+	return map;
+}
+
+void chunk_map_free(ChunkMap* map) {
+	map->chunks_ = {};
+	map->free_chunks_ = {};
+	map->index_ = {};
+}
+
+void chunk_map_set_rule(ChunkMap* map, Rule rule) {
+	map->rule_ = rule;
+	// Chunks that were stable under the old rule need not be under the new one.
+	for (chunk_map_chunk& chunk : map->chunks_)
+		chunk.changed_ = chunk.in_use_;
+}
+
+bool get_cell(const ChunkMap* map, int64_t x, int64_t y) {
+	uint32_t index = find_chunk(map, static_cast<int32_t>(x >> 6), static_cast<int32_t>(y >> 6));
+	if (index == chunk_map_no_chunk) return false;
+	return (map->chunks_[index].rows_[map->current_][y & 63] >> (x & 63)) & 1;
+}
+
+void write_cell(ChunkMap* map, int64_t x, int64_t y, bool new_value) {
+	assert((x >> 6) == static_cast<int32_t>(x >> 6) && (y >> 6) == static_cast<int32_t>(y >> 6));
+	int32_t chunk_x = static_cast<int32_t>(x >> 6);
+	int32_t chunk_y = static_cast<int32_t>(y >> 6);
+	uint32_t index = find_chunk(map, chunk_x, chunk_y);
+	if (index == chunk_map_no_chunk) {
+		if (!new_value) return;
+		index = allocate_chunk(map, chunk_x, chunk_y);
+	}
+
+	chunk_map_chunk& chunk = map->chunks_[index];
+	uint64_t& word = chunk.rows_[map->current_][y & 63];
+	uint64_t bit = uint64_t(1) << (x & 63);
+	word = new_value ? word | bit : word & ~bit;
+	chunk.changed_ = true;
+}
+
+uint64_t chunk_map_population(const ChunkMap* map) {
+	uint64_t population = 0;
+	for (const chunk_map_chunk& chunk : map->chunks_) {
+		if (!chunk.in_use_) continue;
+		for (uint64_t row : chunk.rows_[map->current_])
+			population += std::popcount(row);
+	}
+	return population;
+}
+
+size_t chunk_map_chunk_count(const ChunkMap* map) {
+	return map->index_.size();
+}
+
+void chunk_map_next_generation(ChunkMap* map) {
+	const uint32_t current = map->current_;
+
+	// Births can only happen just outside of a chunk whose border is alive, so
+	// those are the only places that need a new chunk. New chunks are empty and
+	// never need one themselves.
+	const uint32_t chunk_count = static_cast<uint32_t>(map->chunks_.size());
+	for (uint32_t i = 0; i < chunk_count; ++i) {
+		if (!map->chunks_[i].in_use_) continue;
+		for (int32_t dy = -1; dy <= 1; ++dy) {
+			for (int32_t dx = -1; dx <= 1; ++dx) {
+				const chunk_map_chunk& chunk = map->chunks_[i];
+				if (chunk.neighbours_[direction(dx, dy)] != chunk_map_no_chunk) continue;
+				if (border_live(chunk.rows_[current], dx, dy))
+					allocate_chunk(map, chunk.x_ + dx, chunk.y_ + dy);
+			}
+		}
+	}
+
+	dispatch_rule(map->rule_, [map](const auto& rule) {
+		for (chunk_map_chunk& chunk : map->chunks_) {
+			if (!chunk.in_use_) continue;
+			if (chunk_active(map, chunk)) step_chunk(rule, map, chunk);
+			else chunk.next_changed_ = false;
+		}
+	});
+	for (chunk_map_chunk& chunk : map->chunks_)
+		chunk.changed_ = chunk.next_changed_;
+	map->current_ = current ^ 1;
+	++map->generation_;
+
+	// Chunks that stayed empty for a generation are freed, unless a neighbour would
+	// allocate them again. A chunk that just emptied still has to make its
+	// neighbours step once more.
+	for (uint32_t i = 0; i < map->chunks_.size(); ++i) {
+		const chunk_map_chunk& chunk = map->chunks_[i];
+		if (!chunk.in_use_ || chunk.changed_ || !chunk_empty(chunk.rows_[map->current_])) continue;
+		bool needed = false;
+		for (int32_t dy = -1; dy <= 1 && !needed; ++dy) {
+			for (int32_t dx = -1; dx <= 1 && !needed; ++dx) {
+				uint32_t neighbour = chunk.neighbours_[direction(dx, dy)];
+				if (neighbour == i || neighbour == chunk_map_no_chunk) continue;
+				needed = border_live(map->chunks_[neighbour].rows_[map->current_], -dx, -dy);
+			}
+		}
+		if (!needed) free_chunk(map, i);
+	}
+}
+
+void chunk_map_next_generations(ChunkMap* map, uint64_t generation_count) {
+	for (uint64_t i = 0; i < generation_count; ++i)
+		chunk_map_next_generation(map);
+}
@@ -0,0 +1,121 @@
+#include <frame_renderer.hpp>
+#include <algorithm>
+#include <bit>
+#include <string.h>
+
+frame_renderer::frame_renderer(pixel alive_color, pixel dead_color)
+{
+	palette_[0] = dead_color;
+	for (uint32_t density = 1; density < 256; ++density) {
+		// A quarter of the way for density 1, all the way for 255.
+		const uint32_t weight = 64 + (density - 1) * 192 / 254;
+		pixel color = 0;
+		for (int shift = 0; shift < 32; shift += 8) {
+			const uint32_t dead = (dead_color >> shift) & 0xff;
+			const uint32_t alive = (alive_color >> shift) & 0xff;
+			color |= ((dead * (256 - weight) + alive * weight) >> 8) << shift;
+		}
+		palette_[density] = color;
+	}
+}
+
+tmpl8::rect frame_renderer::draw(const board_frame& frame, tmpl8::surface& screen)
+{
+	const bool redraw = !drawn_ || !(drawn_view_ == frame.view_);
+	drawn_ = true;
+	drawn_view_ = frame.view_;
+	dirty_ = frame.view_.zoom_ >= 0 ? draw_cells(frame, screen, redraw) : draw_density(frame, screen, redraw);
+	// Written through buffer(), so the screen has to be told.
+	screen.mark_dirty(dirty_);
+	return dirty_;
+}
+
+tmpl8::rect frame_renderer::draw_cells(const board_frame& frame, tmpl8::surface& screen, bool redraw)
+{
+	const size_t words = frame.words_per_row_;
+	if (redraw) drawn_cells_.assign(frame.cells_.size(), 0);
+
+	const int32_t zoom = frame.view_.zoom_;
+	const int32_t scale = 1 << zoom;
+	pixel* const buffer = screen.buffer();
+	const int32_t pitch = screen.pitch();
+	const size_t columns = std::min<size_t>(frame.columns_, (screen.width() + scale - 1) >> zoom);
+	const size_t rows = std::min<size_t>(frame.rows_, (screen.height() + scale - 1) >> zoom);
+	const size_t word_count = (columns + 63) / 64;
+	// The columns past the screen in the last word.
+	const uint64_t last_mask = columns % 64 == 0 ? ~uint64_t(0) : (uint64_t(1) << (columns % 64)) - 1;
+	size_t min_x = SIZE_MAX, max_x = 0, min_y = SIZE_MAX, max_y = 0;
+	for (size_t r = 0; r < rows; ++r) {
+		const uint64_t* row = frame.cells_.data() + r * words;
+		uint64_t* drawn_row = drawn_cells_.data() + r * words;
+		const int32_t y_begin = static_cast<int32_t>(r) << zoom;
+		const int32_t y_end = std::min(y_begin + scale, screen.height());
+		bool row_changed = false;
+		for (size_t i = 0; i < word_count; ++i) {
+			uint64_t changed = redraw ? ~uint64_t(0) : row[i] ^ drawn_row[i];
+			if (i + 1 == word_count) changed &= last_mask;
+			if (changed == 0) continue;
+			drawn_row[i] = row[i];
+			row_changed = true;
+			min_x = std::min<size_t>(min_x, i * 64 + std::countr_zero(changed));
+			max_x = std::max<size_t>(max_x, i * 64 + 63 - std::countl_zero(changed));
+			for (; changed != 0; changed &= changed - 1) {
+				const int bit = std::countr_zero(changed);
+				const pixel color = palette_[(row[i] >> bit) & 1 ? 255 : 0];
+				const int32_t x_begin = static_cast<int32_t>(i * 64 + bit) << zoom;
+				const int32_t x_end = std::min(x_begin + scale, screen.width());
+				for (int32_t y = y_begin; y < y_end; ++y)
+					std::fill(buffer + y * pitch + x_begin, buffer + y * pitch + x_end, color);
+			}
+		}
+		if (row_changed) {
+			min_y = std::min(min_y, r);
+			max_y = r;
+		}
+	}
+	if (min_y == SIZE_MAX) return tmpl8::rect();
+	return tmpl8::rect{
+		static_cast<int32_t>(min_x) << zoom, static_cast<int32_t>(min_y) << zoom,
+		static_cast<int32_t>(max_x + 1) << zoom, static_cast<int32_t>(max_y + 1) << zoom };
+}
+
+tmpl8::rect frame_renderer::draw_density(const board_frame& frame, tmpl8::surface& screen, bool redraw)
+{
+	if (redraw) drawn_density_.assign(frame.density_.size(), 0);
+
+	pixel* const buffer = screen.buffer();
+	const int32_t pitch = screen.pitch();
+	const size_t columns = std::min<size_t>(frame.columns_, screen.width());
+	const size_t rows = std::min<size_t>(frame.rows_, screen.height());
+	size_t min_x = SIZE_MAX, max_x = 0, min_y = SIZE_MAX, max_y = 0;
+	for (size_t r = 0; r < rows; ++r) {
+		const uint8_t* row = frame.density_.data() + r * frame.columns_;
+		uint8_t* drawn_row = drawn_density_.data() + r * frame.columns_;
+		pixel* pixels = buffer + r * pitch;
+		bool row_changed = false;
+		for (size_t c = 0; c < columns; c += 8) {
+			// Eight cells at a time: most of a settled board is the same as before.
+			const size_t count = std::min<size_t>(8, columns - c);
+			uint64_t now = 0, before = 0;
+			memcpy(&now, row + c, count);
+			memcpy(&before, drawn_row + c, count);
+			if (!redraw && now == before) continue;
+			row_changed = true;
+			for (size_t j = 0; j < count; ++j) {
+				if (!redraw && row[c + j] == drawn_row[c + j]) continue;
+				drawn_row[c + j] = row[c + j];
+				pixels[c + j] = palette_[row[c + j]];
+				min_x = std::min(min_x, c + j);
+				max_x = std::max(max_x, c + j);
+			}
+		}
+		if (row_changed) {
+			min_y = std::min(min_y, r);
+			max_y = r;
+		}
+	}
+	if (min_y == SIZE_MAX) return tmpl8::rect();
+	return tmpl8::rect{
+		static_cast<int32_t>(min_x), static_cast<int32_t>(min_y),
+		static_cast<int32_t>(max_x + 1), static_cast<int32_t>(max_y + 1) };
+}
@@ -1,8 +1,17 @@
 #include <game.hpp>
 #include <config.hpp>
+#include <board_view.hpp>
+#include <checkpoint_writer.hpp>
+#include <frame_renderer.hpp>
+#include <grid.hpp>
+#include <grid_png.hpp>
+#include <grid_snapshot.hpp>
+#include <pattern_file.hpp>
+#include <simulation.hpp>
 #include <sstream>
 #include <iomanip>
 #include <vector>
+#include <algorithm>
 #include <stdexcept>
 #include <stdio.h>
 #include <stddef.h>
@@ -28,124 +37,135 @@ void sleep(unsigned milliseconds)
 using namespace tmpl8;
 using namespace config;
 
-typedef struct Grid {
-	size_t width_;
-	size_t height_;
-	bool* cells_;
-	bool* cells_buffer_;
-} Grid;
-
-
 int32_t mouse_x, mouse_y;
-float timer = 0;
-bool start = false;
 Grid grid;
-
-Grid grid_init(size_t width, size_t height) {
-	size_t cell_count = width * height;
-	auto memory = static_cast<bool*>(calloc(cell_count * 2, sizeof(bool)));;
-	assert(memory);
-	Grid grid = {
-		.width_ = width,
-		.height_ = height,
-		.cells_ = memory,
-		.cells_buffer_ = memory + cell_count,
-	};
-	return grid;
-}
-void grid_free(Grid* grid) {
-	free(grid->cells_ < grid->cells_buffer_ ? grid->cells_ : grid->cells_buffer_);
-}
-bool get_cell(Grid* grid, size_t x, size_t y) {
-	assert(x < grid->width_);
-	assert(y < grid->height_);
-	return grid->cells_[y * grid->width_ + x];
-}
-
-size_t alive_neighbours(Grid* grid, size_t x, size_t y) {
-	size_t min_x = x == 0 ? 0 : x - 1;
-	size_t max_x = x == grid->width_ - 1 ? grid->width_ - 1 : x + 1;
-	size_t min_y = y == 0 ? 0 : y - 1;
-	size_t max_y = y == grid->height_ - 1 ? grid->height_ - 1 : y + 1;
-	size_t alive_neighbour_count = 0;
-	for (size_t current_y = min_y; current_y <= max_y; ++current_y) {
-		for (size_t current_x = min_x; current_x <= max_x; ++current_x) {
-			if (get_cell(grid, current_x, current_y)) {
-				++alive_neighbour_count;
-			}
-		}
-	}
-	if (get_cell(grid, x, y)) {
-		--alive_neighbour_count;
-	}
-	return alive_neighbour_count;
-}
-void write_cell(Grid* grid, size_t x, size_t  y, bool new_value) {
-	assert(x < grid->width_);
-	assert(y < grid->height_);
-	grid->cells_[y * grid->width_ + x] = new_value;
-}
-void write_cell_cells_buffer(Grid* grid, size_t x, size_t y, bool new_value) {
-	assert(x < grid->width_);
-	assert(y < grid->height_);
-	grid->cells_buffer_[y * grid->width_ + x] = new_value;
-}
-void grid_next_generation(Grid* grid) {
-	for (size_t y = 0; y < grid->height_; ++y) {
-		for (size_t x = 0; x < grid->width_; ++x){
-			size_t alive_neighbours_count = alive_neighbours(grid, x, y);
-			bool new_state = alive_neighbours_count == 3 ||
-				(alive_neighbours_count == 2 && get_cell(grid, x, y));
-			write_cell_cells_buffer(grid, x, y, new_state);
-		}
+checkpoint_writer* checkpoints = nullptr;
+simulation* sim = nullptr;
+frame_renderer renderer;
+board_view view;
+step_speed speed;
+// The generation of the last checkpoint, on the simulation thread.
+uint64_t checkpoint_generation = 0;
+// Where '=' stops doubling the generations per step, long before they wrap around.
+constexpr uint64_t max_generations_per_step = uint64_t(1) << 40;
+
+
+// Moves or zooms the view for the camera keys. Returns false for any other key.
+bool move_view(key key) {
+	// A quarter of the screen, but at least a cell.
+	const int64_t step_x = std::max<int64_t>(view.width_ / 4, view.zoom_ > 0 ? int64_t(1) << view.zoom_ : 1);
+	const int64_t step_y = std::max<int64_t>(view.height_ / 4, view.zoom_ > 0 ? int64_t(1) << view.zoom_ : 1);
+	switch (key) {
+	case key::left:      view = board_view_pan(view, -step_x, 0); break;
+	case key::right:     view = board_view_pan(view, step_x, 0); break;
+	case key::down:      view = board_view_pan(view, 0, -step_y); break;
+	case key::up:        view = board_view_pan(view, 0, step_y); break;
+	case key::page_up:   view = board_view_zoom(view, 1); break;
+	case key::page_down: view = board_view_zoom(view, -1); break;
+	case key::home:      view = board_view_fit(grid.width_, grid.height_, view.width_, view.height_); break;
+	default: return false;
 	}
-	bool* temp = grid->cells_;
-	grid->cells_ = grid->cells_buffer_;
-	grid->cells_buffer_ = temp;
+	sim->set_view(view);
+	return true;
 }
 
-void grid_print(Grid* grid, surface& screen) {
-	assert(grid->height_ <= screen_height);
-	assert(grid->width_ <= screen_width);
-	for (size_t y = 0; y < grid->height_; ++y) {
-		for (size_t x = 0; x < grid->width_; ++x) {
-			if (get_cell(grid, x, y)) {
-				screen.plot(x, y, 0xffffffff);
-			}
-		}
+
+// Replaces grid by the snapshot at path if it holds a board of width by height.
+bool resume_snapshot(const char* path, size_t width, size_t height) {
+	if (path == nullptr) return false;
+	Grid resumed = grid_init(1, 1);
+	if (!grid_load_snapshot(&resumed, path) || resumed.width_ != width || resumed.height_ != height) {
+		grid_free(&resumed);
+		return false;
 	}
+	grid_free(&grid);
+	grid = resumed;
+	return true;
 }
 
 
 game::game(surface& screen) : screen_(screen)
 {	
-	grid = grid_init(screen.width(), screen.height());
+	grid = grid_init(board_width != 0 ? board_width : screen.width(), board_height != 0 ? board_height : screen.height());
+	if (!resume_snapshot(snapshot_path, grid.width_, grid.height_)) {
+		Rule rule;
+		bool rule_valid = rule_parse(simulation_rule, &rule);
+		assert(rule_valid);
+		if (rule_valid) grid_set_rule(&grid, rule);
+
+		if (start_pattern != nullptr) {
+			// The first read only finds the bounding box, to centre the pattern.
+			PatternInfo info;
+			if (pattern_read(start_pattern, [](int64_t, int64_t, uint64_t) {}, &info) && info.population_ > 0) {
+				int64_t x = static_cast<int64_t>(grid.width_ / 2) - (info.min_x_ + info.max_x_) / 2;
+				int64_t y = static_cast<int64_t>(grid.height_ / 2) - (info.min_y_ + info.max_y_) / 2;
+				grid_load_pattern(&grid, start_pattern, x, y, &info);
+				if (info.rule_valid_) grid_set_rule(&grid, info.rule_);
+			}
+		}
+		else if (start_density > 0) {
+			grid_randomize(&grid, start_density, start_seed);
+		}
+	}
+	grid_set_thread_count(&grid, simulation_threads);
+	// Zoomed out views add up the populations of whole tiles instead of counting cells.
+	grid_track_stats(&grid, true);
+	if (snapshot_path != nullptr && checkpoint_generations != 0) {
+		// One spare buffer: a checkpoint waits for the one before it to be written.
+		checkpoints = new checkpoint_writer(1, compress_snapshots);
+	}
+	speed.generations_ = generations_per_step;
+	speed.budget_ = std::chrono::microseconds(static_cast<int64_t>(step_budget_ms * 1000));
+	speed.hyper_ = hyper_speed;
+	checkpoint_generation = grid.generation_;
+	view = board_view_fit(grid.width_, grid.height_, screen.width(), screen.height());
+	sim = new simulation(&grid, simulation_rate, speed, view, [](Grid* grid) {
+		// A step of many generations can jump over a multiple: checkpoint on the first step past it.
+		if (checkpoint_generations != 0 && checkpoints != nullptr &&
+			grid->generation_ / checkpoint_generations != checkpoint_generation / checkpoint_generations) {
+			// Resumed from snapshot_path, the grid may still be mapped from it.
+			grid_release_mapping(grid);
+			if (!checkpoints->check()) fprintf(stderr, "Could not write a checkpoint to %s\n", snapshot_path);
+			checkpoints->checkpoint(grid, snapshot_path);
+			checkpoint_generation = grid->generation_;
+		}
+	});
 }
 
 
 game::~game()
 {
+	// The simulation stops first, then queued checkpoints go, or they would overwrite the last state.
+	delete sim;
+	sim = nullptr;
+	if (checkpoints != nullptr && !checkpoints->flush()) fprintf(stderr, "Could not write a checkpoint to %s\n", snapshot_path);
+	delete checkpoints;
+	checkpoints = nullptr;
+	if (snapshot_path != nullptr) {
+		grid_release_mapping(&grid);
+		const bool saved = compress_snapshots ? grid_save_compressed_snapshot(&grid, snapshot_path) : grid_save_snapshot(&grid, snapshot_path);
+		if (!saved) fprintf(stderr, "Could not save the board to %s\n", snapshot_path);
+	}
 	grid_free(&grid);
 }
 
 void game::tick(float delta_time)
 {
-	if (start) {
-		timer += delta_time;
-		if (timer >= 0.1f) {
-			timer -= 0.1f;
-			grid_next_generation(&grid);
-	}
-		screen_.clear(0x000000);
-		grid_print(&grid, screen_);
-	}
+	// The simulation steps on its own thread; only draw what it published since the last frame.
+	if (sim->update_frame()) renderer.draw(sim->frame(), screen_);
 }
 
 
 void game::mouse_down(mouse_button button, modifiers modifiers)
 {	
-	get_cell(&grid, mouse_x, mouse_y) ? write_cell(&grid, mouse_x, mouse_y, false) : write_cell(&grid, mouse_x, mouse_y, true);
-	grid_print(&grid, screen_);
+	// Zoomed out a pixel is a block of cells: nothing to toggle.
+	if (mouse_x < 0 || mouse_y < 0 || mouse_x >= screen_width || mouse_y >= screen_height || view.zoom_ < 0) return;
+	int64_t x, y;
+	board_view_cell(view, mouse_x, mouse_y, &x, &y);
+	if (x < 0 || y < 0 || x >= static_cast<int64_t>(grid.width_) || y >= static_cast<int64_t>(grid.height_)) return;
+	sim->edit([x, y](Grid* grid) {
+		write_cell(grid, x, y, !get_cell(grid, x, y));
+	});
 }
 
 void game::mouse_up(mouse_button button, modifiers modifiers)
@@ -163,17 +183,40 @@ void game::mouse_move(int32_t x, int32_t y)
 
 void game::key_down(key key, modifiers modifiers)
 {
+	if (move_view(key)) return;
 	switch (key) {
 	case key::w:
-		if (start != true)
-			start = true;
-		else
-			start = false;
+		sim->set_running(!sim->running());
 		break;
 	case key::a:
-		if (start != true) {
-			grid_print(&grid, screen_);
+		if (!sim->running()) {
+			renderer.invalidate();
+			renderer.draw(sim->frame(), screen_);
+		}
+		break;
+	case key::equal:
+	case key::minus:
+		// Doubles or halves whatever sets the step: the budget if there is one.
+		if (speed.budget_ != std::chrono::microseconds::zero()) {
+			speed.budget_ = key == key::equal ? speed.budget_ * 2 : std::max(speed.budget_ / 2, std::chrono::microseconds(1));
 		}
+		else {
+			speed.generations_ = key == key::equal ? std::min(speed.generations_ * 2, max_generations_per_step) : std::max<uint64_t>(speed.generations_ / 2, 1);
+		}
+		sim->set_speed(speed);
+		break;
+	case key::h:
+		speed.hyper_ = !speed.hyper_;
+		sim->set_speed(speed);
+		break;
+	case key::p:
+		// The board itself, one pixel per cell, rather than the scaled up screen.
+		sim->edit([](Grid* grid) {
+			char path[64];
+			snprintf(path, sizeof path, "board_%llu.png", static_cast<unsigned long long>(grid->generation_));
+			grid_save_png(grid, path);
+		});
+		break;
 	}
 	
 }
@@ -185,6 +228,7 @@ void game::key_up(key key, modifiers modifiers)
 
 void game::key_repeat(key key, modifiers modifiers)
 {
+	move_view(key);
 }
 
 void game::key_char(uint32_t letter)
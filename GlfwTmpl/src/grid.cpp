@@ -0,0 +1,705 @@
+#include <grid.hpp>
+#include <grid_kernel.hpp>
+#include <grid_snapshot.hpp>
+#include <thread_pool.hpp>
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <vector>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+namespace
+{
+	size_t words_for_width(size_t width)
+	{
+		return (width + 63) / 64;
+	}
+
+	size_t tile_index(const Grid* grid, size_t x, size_t y)
+	{
+		return (y / grid_tile_size) * grid->words_per_row_ + x / 64;
+	}
+
+	// A tile has to be stepped when it, or one of the eight tiles around it,
+	// changed in the last generation. Every other tile is equal in both buffers.
+	bool tile_active(const Grid* grid, size_t tile_row, size_t tile_column)
+	{
+		const size_t tile_columns = grid->words_per_row_;
+		if (grid->border_changed_ &&
+			(tile_row == 0 || tile_row + 1 == grid->tile_rows_ || tile_column == 0 || tile_column + 1 == tile_columns))
+			return true;
+		size_t row_begin = tile_row == 0 ? 0 : tile_row - 1;
+		size_t row_end = tile_row + 2 < grid->tile_rows_ ? tile_row + 2 : grid->tile_rows_;
+		size_t column_begin = tile_column == 0 ? 0 : tile_column - 1;
+		size_t column_end = tile_column + 2 < tile_columns ? tile_column + 2 : tile_columns;
+		for (size_t row = row_begin; row < row_end; ++row) {
+			for (size_t column = column_begin; column < column_end; ++column) {
+				if (grid->tile_changes_[row * tile_columns + column] != 0) return true;
+			}
+		}
+		return false;
+	}
+
+	// Reads cell x of a row, where x = -1 and x = width are the halo cells.
+	bool row_cell(const Grid* grid, const uint64_t* row, ptrdiff_t x)
+	{
+		if (x < 0) return row[-1] >> 63;
+		if (x >= static_cast<ptrdiff_t>(grid->width_)) return row[grid->words_per_row_] & 1;
+		return (row[x / 64] >> (x % 64)) & 1;
+	}
+
+	void set_row_cell(const Grid* grid, uint64_t* row, ptrdiff_t x)
+	{
+		if (x < 0) row[-1] |= uint64_t(1) << 63;
+		else if (x >= static_cast<ptrdiff_t>(grid->width_)) row[grid->words_per_row_] |= 1;
+		else row[x / 64] |= uint64_t(1) << (x % 64);
+	}
+
+	// Copies a row, halo words included, with x flipped.
+	void copy_row_flipped(const Grid* grid, const uint64_t* src, uint64_t* dst)
+	{
+		const ptrdiff_t width = static_cast<ptrdiff_t>(grid->width_);
+		memset(dst - 1, 0, grid->stride_ * sizeof(uint64_t));
+		for (ptrdiff_t x = -1; x <= width; ++x) {
+			if (row_cell(grid, src, width - 1 - x)) set_row_cell(grid, dst, x);
+		}
+	}
+
+	// Fills in the halo of cells_ for the next generation: first the halo words of
+	// every row, then the halo rows, which copy the halo words of their source row
+	// along and so get the corners right.
+	void fill_halo(Grid* grid)
+	{
+		if (grid->boundary_ == grid_boundary::dead) return;
+
+		const size_t stride = grid->stride_;
+		const size_t words = grid->words_per_row_;
+		const ptrdiff_t last_column = static_cast<ptrdiff_t>(grid->width_) - 1;
+		const bool mirror = grid->boundary_ == grid_boundary::mirror;
+		for (size_t y = 0; y < grid->height_; ++y) {
+			uint64_t* row = grid->cells_ + y * stride;
+			uint64_t left = row_cell(grid, row, mirror ? 0 : last_column);
+			uint64_t right = row_cell(grid, row, mirror ? last_column : 0);
+			row[-1] = left << 63;
+			row[words] = right;
+		}
+
+		const uint64_t* first_row = grid->cells_;
+		const uint64_t* last_row = grid->cells_ + (grid->height_ - 1) * stride;
+		uint64_t* top_halo = grid->cells_ - stride;
+		uint64_t* bottom_halo = grid->cells_ + grid->height_ * stride;
+		switch (grid->boundary_)
+		{
+		case grid_boundary::torus:
+			memcpy(top_halo - 1, last_row - 1, stride * sizeof(uint64_t));
+			memcpy(bottom_halo - 1, first_row - 1, stride * sizeof(uint64_t));
+			break;
+		case grid_boundary::mirror:
+			memcpy(top_halo - 1, first_row - 1, stride * sizeof(uint64_t));
+			memcpy(bottom_halo - 1, last_row - 1, stride * sizeof(uint64_t));
+			break;
+		case grid_boundary::klein_bottle:
+			copy_row_flipped(grid, last_row, top_halo);
+			copy_row_flipped(grid, first_row, bottom_halo);
+			break;
+		case grid_boundary::dead:
+			break;
+		}
+
+		// Across a wrapping edge the tiles on the other side are neighbours too.
+		// Mirrored edges only reflect cells of the edge tile itself.
+		bool border_changed = false;
+		if (grid->boundary_ != grid_boundary::mirror) {
+			const size_t tile_columns = words;
+			const uint64_t* last_tile_row = grid->tile_changes_ + (grid->tile_rows_ - 1) * tile_columns;
+			for (size_t column = 0; column < tile_columns; ++column)
+				border_changed |= grid->tile_changes_[column] != 0 || last_tile_row[column] != 0;
+			for (size_t tile_row = 0; tile_row < grid->tile_rows_; ++tile_row) {
+				const uint64_t* changes = grid->tile_changes_ + tile_row * tile_columns;
+				border_changed |= changes[0] != 0 || changes[tile_columns - 1] != 0;
+			}
+		}
+		grid->border_changed_ = border_changed;
+	}
+
+	// Hashes the cells of a tile, and where it is, so that tiles hash differently
+	// on every spot of the board. Four xxHash64 lanes over the rows keep several
+	// multiplications in flight, the splitmix64 finaliser mixes them together.
+	uint64_t hash_tile(const Grid* grid, const uint64_t* cells, size_t tile_row, size_t tile_column)
+	{
+		constexpr uint64_t prime_1 = 0x9e3779b185ebca87;
+		constexpr uint64_t prime_2 = 0xc2b2ae3d27d4eb4f;
+		auto round = [](uint64_t lane, uint64_t word) { return std::rotl(lane + word * prime_2, 31) * prime_1; };
+
+		const size_t stride = grid->stride_;
+		const size_t y_end = tile_row * grid_tile_size + grid_tile_size < grid->height_ ? tile_row * grid_tile_size + grid_tile_size : grid->height_;
+		const uint64_t* word = cells + tile_row * grid_tile_size * stride + tile_column;
+		uint64_t lanes[4] = { prime_1, prime_2, ~prime_1, ~prime_2 };
+		size_t y = tile_row * grid_tile_size;
+		for (; y + 4 <= y_end; y += 4, word += 4 * stride) {
+			lanes[0] = round(lanes[0], word[0]);
+			lanes[1] = round(lanes[1], word[stride]);
+			lanes[2] = round(lanes[2], word[2 * stride]);
+			lanes[3] = round(lanes[3], word[3 * stride]);
+		}
+		for (; y < y_end; ++y, word += stride)
+			lanes[0] = round(lanes[0], word[0]);
+
+		uint64_t hash = std::rotl(lanes[0], 1) + std::rotl(lanes[1], 7) + std::rotl(lanes[2], 12) + std::rotl(lanes[3], 18);
+		hash ^= (tile_row * grid->words_per_row_ + tile_column) * prime_1;
+		hash = (hash ^ (hash >> 30)) * 0xbf58476d1ce4e5b9;
+		hash = (hash ^ (hash >> 27)) * 0x94d049bb133111eb;
+		return hash ^ (hash >> 31);
+	}
+
+	// Draw counter of a counter-based generator, SplitMix64: the output only
+	// depends on key and counter, so any thread can draw any word.
+	uint64_t random_word(uint64_t key, uint64_t counter)
+	{
+		uint64_t x = key + (counter + 1) * 0x9e3779b97f4a7c15;
+		x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9;
+		x = (x ^ (x >> 27)) * 0x94d049bb133111eb;
+		return x ^ (x >> 31);
+	}
+
+	// The levels of tile sums above the tiles: enough that the last is a single block over the grid.
+	uint32_t tile_sum_levels(const Grid* grid)
+	{
+		return static_cast<uint32_t>(std::max(std::bit_width(grid->words_per_row_ - 1), std::bit_width(grid->tile_rows_ - 1)));
+	}
+
+	// The words of all the tile sums, level 1 up.
+	size_t tile_sum_count(const Grid* grid)
+	{
+		size_t count = 0;
+		size_t columns = grid->words_per_row_, rows = grid->tile_rows_;
+		for (uint32_t level = 1; level <= tile_sum_levels(grid); ++level) {
+			columns = (columns + 1) / 2;
+			rows = (rows + 1) / 2;
+			count += columns * rows;
+		}
+		return count;
+	}
+
+	// A change in the population of a tile, or of a block of tiles.
+	struct tile_delta
+	{
+		size_t column_;
+		int64_t delta_;
+	};
+
+	// Adds the population changes of tiles in a tile row, by column, to the sums
+	// over them at every level. Tiles under the same block are added up first, so
+	// a block takes one add per tile row. Stripes of tile rows share the blocks
+	// on their edges: the adds are atomic.
+	void add_to_tile_sums(const Grid* grid, size_t tile_row, tile_delta* deltas, size_t count)
+	{
+		uint64_t* sums = grid->tile_sums_;
+		size_t columns = grid->words_per_row_, rows = grid->tile_rows_;
+		const uint32_t levels = tile_sum_levels(grid);
+		for (uint32_t level = 1; level <= levels && count != 0; ++level) {
+			columns = (columns + 1) / 2;
+			rows = (rows + 1) / 2;
+			size_t merged = 0;
+			for (size_t i = 0; i < count; ++i) {
+				const size_t column = deltas[i].column_ / 2;
+				if (merged != 0 && deltas[merged - 1].column_ == column) {
+					deltas[merged - 1].delta_ += deltas[i].delta_;
+				}
+				else {
+					deltas[merged] = { column, deltas[i].delta_ };
+					++merged;
+				}
+			}
+			count = merged;
+			uint64_t* row = sums + (tile_row >> level) * columns;
+			for (size_t i = 0; i < count; ++i) {
+				if (deltas[i].delta_ != 0)
+					std::atomic_ref<uint64_t>(row[deltas[i].column_]).fetch_add(static_cast<uint64_t>(deltas[i].delta_), std::memory_order_relaxed);
+			}
+			sums += columns * rows;
+		}
+	}
+
+	// Adds up the tile sums from the tiles, level by level.
+	void add_up_tile_sums(Grid* grid)
+	{
+		const uint64_t* below = nullptr;
+		uint64_t* sums = grid->tile_sums_;
+		size_t below_columns = grid->words_per_row_, below_rows = grid->tile_rows_;
+		const uint32_t levels = tile_sum_levels(grid);
+		for (uint32_t level = 1; level <= levels; ++level) {
+			const size_t columns = (below_columns + 1) / 2, rows = (below_rows + 1) / 2;
+			auto population = [&](size_t x, size_t y) {
+				if (x >= below_columns || y >= below_rows) return uint64_t(0);
+				return below == nullptr ? grid->tile_stats_[y * below_columns + x].population_ : below[y * below_columns + x];
+			};
+			for (size_t y = 0; y < rows; ++y) {
+				for (size_t x = 0; x < columns; ++x) {
+					sums[y * columns + x] = population(2 * x, 2 * y) + population(2 * x + 1, 2 * y) +
+						population(2 * x, 2 * y + 1) + population(2 * x + 1, 2 * y + 1);
+				}
+			}
+			below = sums;
+			below_columns = columns;
+			below_rows = rows;
+			sums += columns * rows;
+		}
+	}
+
+	// Adds up every tile of cells_ from scratch, for when the kernel has not stepped them.
+	void add_up_tiles(Grid* grid)
+	{
+		const size_t tile_columns = grid->words_per_row_;
+		for (size_t tile_row = 0; tile_row < grid->tile_rows_; ++tile_row) {
+			grid_tile_stats* stats = grid->tile_stats_ + tile_row * tile_columns;
+			for (size_t column = 0; column < tile_columns; ++column)
+				stats[column] = {};
+			const size_t y_begin = tile_row * grid_tile_size;
+			const size_t y_end = y_begin + grid_tile_size < grid->height_ ? y_begin + grid_tile_size : grid->height_;
+			for (size_t y = y_begin; y < y_end; ++y) {
+				const uint64_t* row = grid->cells_ + y * grid->stride_;
+				for (size_t column = 0; column < tile_columns; ++column) {
+					stats[column].columns_ |= row[column];
+					stats[column].population_ += std::popcount(row[column]);
+				}
+			}
+		}
+		add_up_tile_sums(grid);
+	}
+
+	// Keeps the stats of a tile right as a word of it is written. The population
+	// is exact; columns cleared stay set until the tile is stepped again.
+	void write_tile_stats(Grid* grid, size_t tile, uint64_t old_word, uint64_t new_word)
+	{
+		if (grid->tile_stats_ == nullptr) return;
+		grid_tile_stats& stats = grid->tile_stats_[tile];
+		stats.population_ = stats.population_ - std::popcount(old_word) + std::popcount(new_word);
+		stats.columns_ |= new_word;
+		tile_delta delta = { tile % grid->words_per_row_, std::popcount(new_word) - std::popcount(old_word) };
+		add_to_tile_sums(grid, tile / grid->words_per_row_, &delta, 1);
+	}
+
+	kernel_isa active_isa = kernel_isa_detect();
+	grid_step_block_fn step_block = kernel_for_isa(active_isa);
+	grid_randomize_words_fn randomize_words = randomize_kernel_for_isa(active_isa);
+
+	// Steps every active tile of tile rows [tile_row_begin, tile_row_end), in runs
+	// of neighbouring active tiles so the kernel can use whole registers.
+	void step_tile_rows(const Grid* grid, size_t tile_row_begin, size_t tile_row_end)
+	{
+		const size_t tile_columns = grid->words_per_row_;
+		// The tiles stepped in a tile row with their populations before, while there are tile sums to keep.
+		std::vector<tile_delta> stepped;
+		for (size_t tile_row = tile_row_begin; tile_row < tile_row_end; ++tile_row) {
+			size_t y_begin = tile_row * grid_tile_size;
+			size_t y_end = y_begin + grid_tile_size < grid->height_ ? y_begin + grid_tile_size : grid->height_;
+			uint64_t* changes = grid->tile_changes_buffer_ + tile_row * tile_columns;
+			grid_tile_stats* stats = grid->tile_stats_ == nullptr ? nullptr : grid->tile_stats_ + tile_row * tile_columns;
+
+			size_t run_begin = 0;
+			bool in_run = false;
+			for (size_t column = 0; column < tile_columns; ++column) {
+				changes[column] = 0;
+				bool active = tile_active(grid, tile_row, column);
+				// Tiles that are not stepped stay the same, and so do their stats.
+				if (active && grid->tile_sums_ != nullptr) stepped.push_back({ column, -static_cast<int64_t>(stats[column].population_) });
+				if (active && stats != nullptr) stats[column] = {};
+				if (active && !in_run) run_begin = column;
+				if (!active && in_run) step_block(grid, y_begin, y_end, run_begin, column, changes, stats);
+				in_run = active;
+			}
+			if (in_run) step_block(grid, y_begin, y_end, run_begin, tile_columns, changes, stats);
+			if (!stepped.empty()) {
+				for (tile_delta& tile : stepped)
+					tile.delta_ += static_cast<int64_t>(stats[tile.column_].population_);
+				add_to_tile_sums(grid, tile_row, stepped.data(), stepped.size());
+				stepped.clear();
+			}
+
+			// A tile that did not change in this generation, and was not written to
+			// before it, still has the hash of the last one.
+			if (grid->tile_hashes_ == nullptr) continue;
+			const uint64_t* written = grid->tile_changes_ + tile_row * tile_columns;
+			uint64_t* hashes = grid->tile_hashes_ + tile_row * tile_columns;
+			for (size_t column = 0; column < tile_columns; ++column) {
+				if ((changes[column] | written[column]) != 0)
+					hashes[column] = hash_tile(grid, grid->cells_buffer_, tile_row, column);
+			}
+		}
+	}
+}
+
+Grid grid_init(size_t width, size_t height) {
+	Grid grid = grid_init_mapped(width, height, nullptr, nullptr);
+	assert(grid.memory_);
+	return grid;
+}
+
+Grid grid_init_mapped(size_t width, size_t height, uint64_t* buffer, grid_mapping* mapping) {
+	assert(width > 0 && height > 0);
+	size_t words_per_row = words_for_width(width);
+	size_t stride = words_per_row + 2;
+	size_t word_count = stride * (height + 2);
+	size_t tile_rows = (height + grid_tile_size - 1) / grid_tile_size;
+	size_t tile_count = tile_rows * words_per_row;
+	size_t allocated_buffers = buffer == nullptr ? 2 : 1;
+	auto memory = static_cast<uint64_t*>(calloc(word_count * allocated_buffers + tile_count * 2, sizeof(uint64_t)));
+	if (memory == nullptr) return Grid{};
+	uint64_t* tile_changes = memory + word_count * allocated_buffers;
+	Grid grid = {
+		.width_ = width,
+		.height_ = height,
+		.words_per_row_ = words_per_row,
+		.stride_ = stride,
+		.cells_ = (buffer == nullptr ? memory + word_count : buffer) + stride + 1,
+		.cells_buffer_ = memory + stride + 1,
+		.tile_rows_ = tile_rows,
+		.tile_changes_ = tile_changes,
+		.tile_changes_buffer_ = tile_changes + tile_count,
+		.rule_ = rule_conway,
+		.boundary_ = grid_boundary::dead,
+		.border_changed_ = false,
+		.tile_stats_ = nullptr,
+		.tile_sums_ = nullptr,
+		.tile_hashes_ = nullptr,
+		.generation_ = 0,
+		.pool_ = nullptr,
+		.memory_ = memory,
+		.mapping_ = mapping,
+	};
+	return grid;
+}
+
+void grid_free(Grid* grid) {
+	free(grid->memory_);
+	grid->memory_ = nullptr;
+	free(grid->tile_stats_);
+	grid->tile_stats_ = nullptr;
+	free(grid->tile_sums_);
+	grid->tile_sums_ = nullptr;
+	free(grid->tile_hashes_);
+	grid->tile_hashes_ = nullptr;
+	if (grid->mapping_ != nullptr) grid_mapping_release(grid->mapping_);
+	grid->mapping_ = nullptr;
+	delete grid->pool_;
+	grid->pool_ = nullptr;
+}
+
+void grid_release_mapping(Grid* grid) {
+	if (grid->mapping_ == nullptr) return;
+	// Laid out like grid_init lays out its memory, each buffer where it was.
+	const size_t word_count = grid->stride_ * (grid->height_ + 2);
+	const size_t tile_count = grid->tile_rows_ * grid->words_per_row_;
+	auto memory = static_cast<uint64_t*>(malloc((word_count * 2 + tile_count * 2) * sizeof(uint64_t)));
+	assert(memory);
+	uint64_t* cells = memory + word_count + grid->stride_ + 1;
+	uint64_t* cells_buffer = memory + grid->stride_ + 1;
+	uint64_t* tile_changes = memory + word_count * 2;
+	memcpy(cells - grid->stride_ - 1, grid->cells_ - grid->stride_ - 1, word_count * sizeof(uint64_t));
+	memcpy(cells_buffer - grid->stride_ - 1, grid->cells_buffer_ - grid->stride_ - 1, word_count * sizeof(uint64_t));
+	memcpy(tile_changes, grid->tile_changes_, tile_count * sizeof(uint64_t));
+	memcpy(tile_changes + tile_count, grid->tile_changes_buffer_, tile_count * sizeof(uint64_t));
+
+	free(grid->memory_);
+	grid_mapping_release(grid->mapping_);
+	grid->memory_ = memory;
+	grid->mapping_ = nullptr;
+	grid->cells_ = cells;
+	grid->cells_buffer_ = cells_buffer;
+	grid->tile_changes_ = tile_changes;
+	grid->tile_changes_buffer_ = tile_changes + tile_count;
+}
+
+void grid_set_rule(Grid* grid, Rule rule) {
+	grid->rule_ = rule;
+	// Tiles that were stable under the old rule need not be under the new one.
+	grid_mark_changed(grid);
+}
+
+void grid_set_boundary(Grid* grid, grid_boundary boundary) {
+	grid->boundary_ = boundary;
+	grid->border_changed_ = false;
+	// Going back to dead boundaries needs a clean halo in both buffers; any other
+	// mode fills it in before every generation.
+	uint64_t* buffers[] = { grid->cells_, grid->cells_buffer_ };
+	for (uint64_t* cells : buffers) {
+		memset(cells - grid->stride_ - 1, 0, grid->stride_ * sizeof(uint64_t));
+		memset(cells + grid->height_ * grid->stride_ - 1, 0, grid->stride_ * sizeof(uint64_t));
+		for (size_t y = 0; y < grid->height_; ++y) {
+			uint64_t* row = cells + y * grid->stride_;
+			row[-1] = 0;
+			row[grid->words_per_row_] = 0;
+		}
+	}
+	grid_mark_changed(grid);
+}
+
+void grid_track_stats(Grid* grid, bool track) {
+	if (track == (grid->tile_stats_ != nullptr)) return;
+	free(grid->tile_stats_);
+	grid->tile_stats_ = nullptr;
+	free(grid->tile_sums_);
+	grid->tile_sums_ = nullptr;
+	if (track) {
+		grid->tile_stats_ = static_cast<grid_tile_stats*>(malloc(grid->tile_rows_ * grid->words_per_row_ * sizeof(grid_tile_stats)));
+		assert(grid->tile_stats_);
+		// A grid of a single tile has no sums, but gets an allocation all the same: nullptr is for not tracking.
+		grid->tile_sums_ = static_cast<uint64_t*>(malloc(std::max<size_t>(tile_sum_count(grid), 1) * sizeof(uint64_t)));
+		assert(grid->tile_sums_);
+		add_up_tiles(grid);
+	}
+}
+
+const uint64_t* grid_tile_sums(const Grid* grid, uint32_t level, size_t* columns) {
+	const uint32_t last = std::min(level, tile_sum_levels(grid));
+	if (last == 0 || grid->tile_sums_ == nullptr) return nullptr;
+	const uint64_t* sums = grid->tile_sums_;
+	size_t level_columns = grid->words_per_row_, level_rows = grid->tile_rows_;
+	for (uint32_t i = 1; i <= last; ++i) {
+		if (i != 1) sums += level_columns * level_rows;
+		level_columns = (level_columns + 1) / 2;
+		level_rows = (level_rows + 1) / 2;
+	}
+	*columns = level_columns;
+	return sums;
+}
+
+GridStats grid_stats(const Grid* grid) {
+	const GridStats no_cells = {
+		.population_ = 0,
+		.min_x_ = grid->width_,
+		.min_y_ = grid->height_,
+		.max_x_ = 0,
+		.max_y_ = 0,
+	};
+	GridStats stats = no_cells;
+	const size_t tile_columns = grid->words_per_row_;
+	auto add_columns = [&stats](uint64_t columns, size_t x) {
+		if (columns == 0) return;
+		size_t min_x = x + std::countr_zero(columns);
+		size_t max_x = x + 63 - std::countl_zero(columns);
+		stats.min_x_ = min_x < stats.min_x_ ? min_x : stats.min_x_;
+		stats.max_x_ = max_x > stats.max_x_ ? max_x : stats.max_x_;
+	};
+	auto row_live = [grid](size_t y) {
+		const uint64_t* row = grid->cells_ + y * grid->stride_;
+		uint64_t live = 0;
+		for (size_t i = 0; i < grid->words_per_row_; ++i)
+			live |= row[i];
+		return live != 0;
+	};
+
+	auto scan_cells = [&]() {
+		stats = no_cells;
+		for (size_t y = 0; y < grid->height_; ++y) {
+			const uint64_t* row = grid->cells_ + y * grid->stride_;
+			uint64_t live = 0;
+			for (size_t i = 0; i < tile_columns; ++i) {
+				stats.population_ += std::popcount(row[i]);
+				add_columns(row[i], i * 64);
+				live |= row[i];
+			}
+			if (live == 0) continue;
+			stats.min_y_ = y < stats.min_y_ ? y : stats.min_y_;
+			stats.max_y_ = y;
+		}
+		return stats;
+	};
+	if (grid->tile_stats_ == nullptr) return scan_cells();
+
+	// The tiles give the population and the columns. The rows only come from the
+	// first and last tile rows with live cells, which are scanned.
+	size_t first_tile_row = grid->tile_rows_, last_tile_row = 0;
+	for (size_t tile_row = 0; tile_row < grid->tile_rows_; ++tile_row) {
+		const grid_tile_stats* tiles = grid->tile_stats_ + tile_row * tile_columns;
+		uint64_t population = 0;
+		for (size_t column = 0; column < tile_columns; ++column) {
+			if (tiles[column].population_ == 0) continue;
+			population += tiles[column].population_;
+			add_columns(tiles[column].columns_, column * 64);
+		}
+		if (population == 0) continue;
+		stats.population_ += population;
+		first_tile_row = tile_row < first_tile_row ? tile_row : first_tile_row;
+		last_tile_row = tile_row;
+	}
+	if (stats.population_ == 0) return no_cells;
+
+	const size_t y_begin = first_tile_row * grid_tile_size;
+	const size_t y_end = (last_tile_row + 1) * grid_tile_size < grid->height_ ? (last_tile_row + 1) * grid_tile_size : grid->height_;
+	size_t y = y_begin;
+	while (y < y_end && !row_live(y)) ++y;
+	// The tiles say some row in there is live. Should they be wrong after all,
+	// the cells are counted instead of scanning off the grid.
+	if (y == y_end) return scan_cells();
+	stats.min_y_ = y;
+	y = y_end - 1;
+	while (y > stats.min_y_ && !row_live(y)) --y;
+	stats.max_y_ = y;
+	return stats;
+}
+
+void grid_track_hashes(Grid* grid, bool track) {
+	if (track == (grid->tile_hashes_ != nullptr)) return;
+	free(grid->tile_hashes_);
+	grid->tile_hashes_ = nullptr;
+	if (track) {
+		grid->tile_hashes_ = static_cast<uint64_t*>(malloc(grid->tile_rows_ * grid->words_per_row_ * sizeof(uint64_t)));
+		assert(grid->tile_hashes_);
+		for (size_t tile_row = 0; tile_row < grid->tile_rows_; ++tile_row) {
+			for (size_t column = 0; column < grid->words_per_row_; ++column)
+				grid->tile_hashes_[tile_row * grid->words_per_row_ + column] = hash_tile(grid, grid->cells_, tile_row, column);
+		}
+	}
+}
+
+uint64_t grid_hash(const Grid* grid) {
+	uint64_t hash = 0;
+	for (size_t tile_row = 0; tile_row < grid->tile_rows_; ++tile_row) {
+		for (size_t column = 0; column < grid->words_per_row_; ++column) {
+			hash ^= grid->tile_hashes_ != nullptr ?
+				grid->tile_hashes_[tile_row * grid->words_per_row_ + column] :
+				hash_tile(grid, grid->cells_, tile_row, column);
+		}
+	}
+	return hash;
+}
+
+void grid_set_thread_count(Grid* grid, size_t thread_count) {
+	delete grid->pool_;
+	grid->pool_ = nullptr;
+	if (thread_count != 1) {
+		grid->pool_ = new thread_pool(thread_count);
+	}
+}
+
+bool get_cell(const Grid* grid, size_t x, size_t y) {
+	assert(x < grid->width_);
+	assert(y < grid->height_);
+	uint64_t word = grid->cells_[y * grid->stride_ + x / 64];
+	return (word >> (x % 64)) & 1;
+}
+
+void write_cell(Grid* grid, size_t x, size_t y, bool new_value) {
+	assert(x < grid->width_);
+	assert(y < grid->height_);
+	uint64_t& word = grid->cells_[y * grid->stride_ + x / 64];
+	uint64_t bit = uint64_t(1) << (x % 64);
+	const uint64_t old_word = word;
+	word = new_value ? word | bit : word & ~bit;
+	grid->tile_changes_[tile_index(grid, x, y)] |= bit;
+	write_tile_stats(grid, tile_index(grid, x, y), old_word, word);
+}
+
+void grid_fill_run(Grid* grid, size_t x, size_t y, size_t length, bool new_value) {
+	assert(x + length <= grid->width_);
+	assert(y < grid->height_);
+	uint64_t* row = grid->cells_ + y * grid->stride_;
+	const size_t first_tile = (y / grid_tile_size) * grid->words_per_row_;
+	uint64_t* changes = grid->tile_changes_ + first_tile;
+	const size_t end = x + length;
+	while (x < end) {
+		size_t i = x / 64;
+		size_t bit_end = end - i * 64 < 64 ? end - i * 64 : 64;
+		uint64_t mask = ~uint64_t(0) << (x % 64);
+		if (bit_end < 64) mask &= (uint64_t(1) << bit_end) - 1;
+		const uint64_t old_word = row[i];
+		row[i] = new_value ? row[i] | mask : row[i] & ~mask;
+		changes[i] |= mask;
+		write_tile_stats(grid, first_tile + i, old_word, row[i]);
+		x = (i + 1) * 64;
+	}
+}
+
+void grid_randomize(Grid* grid, double density, uint64_t seed) {
+	const size_t words = grid->words_per_row_;
+	const uint64_t last_mask = grid->width_ % 64 == 0 ? ~uint64_t(0) : (uint64_t(1) << (grid->width_ % 64)) - 1;
+	const uint64_t key = random_word(seed, 0);
+	// Not a number counts as 0, like any other density that is not above it.
+	const uint32_t threshold = !(density > 0) ? 0 : density >= 1 ? UINT32_MAX : static_cast<uint32_t>(density * 4294967296.0);
+	const bool all_alive = density >= 1;
+	const grid_randomize_words_fn fill_words = randomize_words;
+	auto fill_rows = [=](size_t y_begin, size_t y_end) {
+		for (size_t y = y_begin; y < y_end; ++y) {
+			uint64_t* row = grid->cells_ + y * grid->stride_;
+			if (all_alive || threshold == 0) {
+				for (size_t i = 0; i < words; ++i)
+					row[i] = all_alive ? ~uint64_t(0) : 0;
+			}
+			else {
+				fill_words(row, words, key, y * words, threshold);
+			}
+			row[words - 1] &= last_mask;
+		}
+	};
+
+	if (grid->pool_ == nullptr) {
+		fill_rows(0, grid->height_);
+	}
+	else {
+		const size_t stripe_count = grid->pool_->thread_count();
+		grid->pool_->run(1, [=](size_t stripe) {
+			fill_rows(grid->height_ * stripe / stripe_count, grid->height_ * (stripe + 1) / stripe_count);
+		}, [] {});
+	}
+	grid_mark_changed(grid);
+}
+
+void grid_mark_changed(Grid* grid) {
+	for (size_t i = 0; i < grid->tile_rows_ * grid->words_per_row_; ++i)
+		grid->tile_changes_[i] = ~uint64_t(0);
+	if (grid->tile_stats_ != nullptr) add_up_tiles(grid);
+}
+
+void grid_next_generation(Grid* grid) {
+	grid_next_generations(grid, 1);
+}
+
+void grid_next_generations(Grid* grid, size_t generation_count) {
+	auto swap_buffers = [grid] {
+		uint64_t* temp = grid->cells_;
+		grid->cells_ = grid->cells_buffer_;
+		grid->cells_buffer_ = temp;
+		temp = grid->tile_changes_;
+		grid->tile_changes_ = grid->tile_changes_buffer_;
+		grid->tile_changes_buffer_ = temp;
+		++grid->generation_;
+	};
+
+	if (grid->pool_ == nullptr) {
+		for (size_t i = 0; i < generation_count; ++i) {
+			fill_halo(grid);
+			step_tile_rows(grid, 0, grid->tile_rows_);
+			swap_buffers();
+		}
+		return;
+	}
+
+	// Every thread only reads cells_ and only writes its own stripe of tile rows
+	// in cells_buffer_, so a generation needs no locking; only the tile sums
+	// shared by stripes are added to atomically. The buffers are swapped,
+	// and the halo filled in, by the barrier between two generations.
+	const size_t stripe_count = grid->pool_->thread_count();
+	fill_halo(grid);
+	grid->pool_->run(generation_count, [grid, stripe_count](size_t stripe) {
+		size_t tile_row_begin = grid->tile_rows_ * stripe / stripe_count;
+		size_t tile_row_end = grid->tile_rows_ * (stripe + 1) / stripe_count;
+		step_tile_rows(grid, tile_row_begin, tile_row_end);
+	}, [grid, &swap_buffers] {
+		swap_buffers();
+		fill_halo(grid);
+	});
+}
+
+void grid_use_kernel(kernel_isa isa) {
+	active_isa = isa;
+	step_block = kernel_for_isa(isa);
+	randomize_words = randomize_kernel_for_isa(isa);
+}
+
+kernel_isa grid_active_kernel() {
+	return active_isa;
+}
@@ -0,0 +1,40 @@
+#include <grid_history.hpp>
+#include <assert.h>
+
+grid_history::grid_history(size_t table_size) :
+	table_(table_size, entry{ 0, 0 })
+{
+	assert(table_size > 0 && (table_size & (table_size - 1)) == 0);
+}
+
+GridPeriod grid_history::observe(const Grid* grid)
+{
+	const uint64_t hash = grid_hash(grid);
+	const uint64_t generation = grid->generation_ + 1;
+	entry& slot = table_[hash & (table_.size() - 1)];
+
+	GridPeriod period = { .settling_ = grid_settling::running, .period_ = 0 };
+	if (slot.hash_ == hash && slot.generation_ != 0 && slot.generation_ < generation) {
+		period.period_ = generation - slot.generation_;
+		period.settling_ = period.period_ == 1 ? grid_settling::stable : grid_settling::oscillating;
+	}
+	// The newest generation wins, so a period is measured between its last two boards.
+	slot = { hash, generation };
+	return period;
+}
+
+void grid_history::clear()
+{
+	for (entry& slot : table_)
+		slot = { 0, 0 };
+}
+
+GridPeriod grid_run_until_settled(Grid* grid, grid_history* history, uint64_t max_generations) {
+	grid_track_hashes(grid, true);
+	GridPeriod period = history->observe(grid);
+	for (uint64_t i = 0; i < max_generations && period.settling_ == grid_settling::running; ++i) {
+		grid_next_generation(grid);
+		period = history->observe(grid);
+	}
+	return period;
+}
@@ -0,0 +1,175 @@
+#include <grid_kernel.hpp>
+#include <grid_kernel_impl.hpp>
+
+#if defined(_M_X64) || defined(__x86_64__)
+#define GRID_KERNEL_X64 1
+#include <emmintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+#endif
+
+#if defined(GRID_KERNEL_X64)
+namespace
+{
+	struct v128 { __m128i v; };
+
+	inline v128 operator&(v128 a, v128 b) { return { _mm_and_si128(a.v, b.v) }; }
+	inline v128 operator|(v128 a, v128 b) { return { _mm_or_si128 (a.v, b.v) }; }
+	inline v128 operator^(v128 a, v128 b) { return { _mm_xor_si128(a.v, b.v) }; }
+	inline v128 operator~(v128 a) { return { _mm_xor_si128(a.v, _mm_set1_epi32(-1)) }; }
+	inline v128 operator<<(v128 a, int bits) { return { _mm_slli_epi64(a.v, bits) }; }
+	inline v128 operator>>(v128 a, int bits) { return { _mm_srli_epi64(a.v, bits) }; }
+
+	template <>
+	struct reg_traits<v128>
+	{
+		static constexpr size_t words = 2;
+		static v128 load(const uint64_t* src) { return { _mm_loadu_si128(reinterpret_cast<const __m128i*>(src)) }; }
+		static void store(uint64_t* dst, v128 value) { _mm_storeu_si128(reinterpret_cast<__m128i*>(dst), value.v); }
+		static v128 broadcast(uint64_t value) { return { _mm_set1_epi64x(static_cast<long long>(value)) }; }
+	};
+
+	void cpuid(uint32_t leaf, uint32_t subleaf, uint32_t regs[4])
+	{
+#if defined(_MSC_VER)
+		int info[4];
+		__cpuidex(info, static_cast<int>(leaf), static_cast<int>(subleaf));
+		for (int i = 0; i < 4; ++i) regs[i] = static_cast<uint32_t>(info[i]);
+#else
+		__cpuid_count(leaf, subleaf, regs[0], regs[1], regs[2], regs[3]);
+#endif
+	}
+
+	// The register state the OS saves on a context switch (XCR0).
+	uint64_t os_saved_state()
+	{
+#if defined(_MSC_VER)
+		return _xgetbv(0);
+#else
+		uint32_t eax, edx;
+		__asm__ volatile ("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+		return static_cast<uint64_t>(edx) << 32 | eax;
+#endif
+	}
+}
+#endif
+
+void grid_step_block_scalar(const Grid* grid, size_t y_begin, size_t y_end, size_t word_begin, size_t word_end, uint64_t* changes, grid_tile_stats* stats)
+{
+	step_block<uint64_t>(grid, y_begin, y_end, word_begin, word_end, changes, stats);
+}
+
+void grid_step_block_sse2(const Grid* grid, size_t y_begin, size_t y_end, size_t word_begin, size_t word_end, uint64_t* changes, grid_tile_stats* stats)
+{
+#if defined(GRID_KERNEL_X64)
+	step_block<v128>(grid, y_begin, y_end, word_begin, word_end, changes, stats);
+#else
+	step_block<uint64_t>(grid, y_begin, y_end, word_begin, word_end, changes, stats);
+#endif
+}
+
+void batch_step_scalar(const Batch* batch, uint64_t* changed, uint64_t* differs)
+{
+	step_batch<uint64_t>(batch, changed, differs);
+}
+
+void batch_step_sse2(const Batch* batch, uint64_t* changed, uint64_t* differs)
+{
+#if defined(GRID_KERNEL_X64)
+	step_batch<v128>(batch, changed, differs);
+#else
+	step_batch<uint64_t>(batch, changed, differs);
+#endif
+}
+
+void grid_randomize_words_scalar(uint64_t* words, size_t count, uint64_t key, uint64_t first_word, uint32_t threshold)
+{
+	randomize_words<uint64_t>(words, count, key, first_word, threshold);
+}
+
+// SSE2 has no 64-bit multiply: building one from three 32-bit products for two
+// lanes is slower than two scalar multiplies.
+void grid_randomize_words_sse2(uint64_t* words, size_t count, uint64_t key, uint64_t first_word, uint32_t threshold)
+{
+	randomize_words<uint64_t>(words, count, key, first_word, threshold);
+}
+
+kernel_isa kernel_isa_detect()
+{
+#if defined(GRID_KERNEL_X64)
+	uint32_t regs[4];
+	cpuid(0, 0, regs);
+	const uint32_t max_leaf = regs[0];
+
+	cpuid(1, 0, regs);
+	const bool has_osxsave = (regs[2] >> 27) & 1;
+	const bool has_avx = (regs[2] >> 28) & 1;
+	if (!has_osxsave || !has_avx || max_leaf < 7) return kernel_isa::sse2;
+
+	// The OS has to save the YMM (and for AVX-512 the opmask and ZMM) registers.
+	const uint64_t saved = os_saved_state();
+	const bool ymm_saved = (saved & 0x06) == 0x06;
+	const bool zmm_saved = (saved & 0xe6) == 0xe6;
+
+	cpuid(7, 0, regs);
+	const bool has_avx2 = (regs[1] >> 5) & 1;
+	const bool has_avx512f = (regs[1] >> 16) & 1;
+
+	if (has_avx512f && zmm_saved) return kernel_isa::avx512;
+	if (has_avx2 && ymm_saved) return kernel_isa::avx2;
+	return kernel_isa::sse2;
+#else
+	return kernel_isa::scalar;
+#endif
+}
+
+const char* kernel_isa_name(kernel_isa isa)
+{
+	switch (isa)
+	{
+	case kernel_isa::scalar: return "scalar";
+	case kernel_isa::sse2:   return "sse2";
+	case kernel_isa::avx2:   return "avx2";
+	case kernel_isa::avx512: return "avx512";
+	}
+	return "unknown";
+}
+
+grid_step_block_fn kernel_for_isa(kernel_isa isa)
+{
+	switch (isa)
+	{
+	case kernel_isa::scalar: return grid_step_block_scalar;
+	case kernel_isa::sse2:   return grid_step_block_sse2;
+	case kernel_isa::avx2:   return grid_step_block_avx2;
+	case kernel_isa::avx512: return grid_step_block_avx512;
+	}
+	return grid_step_block_scalar;
+}
+
+batch_step_fn batch_kernel_for_isa(kernel_isa isa)
+{
+	switch (isa)
+	{
+	case kernel_isa::scalar: return batch_step_scalar;
+	case kernel_isa::sse2:   return batch_step_sse2;
+	case kernel_isa::avx2:   return batch_step_avx2;
+	case kernel_isa::avx512: return batch_step_avx512;
+	}
+	return batch_step_scalar;
+}
+
+grid_randomize_words_fn randomize_kernel_for_isa(kernel_isa isa)
+{
+	switch (isa)
+	{
+	case kernel_isa::scalar: return grid_randomize_words_scalar;
+	case kernel_isa::sse2:   return grid_randomize_words_sse2;
+	case kernel_isa::avx2:   return grid_randomize_words_avx2;
+	case kernel_isa::avx512: return grid_randomize_words_avx512;
+	}
+	return grid_randomize_words_scalar;
+}
@@ -0,0 +1,70 @@
+// Compiled with AVX2 enabled (/arch:AVX2, -mavx2). Only called when
+// kernel_isa_detect() reports AVX2 support.
+#include <grid_kernel.hpp>
+#include <grid_kernel_impl.hpp>
+
+#if defined(_M_X64) || defined(__x86_64__)
+#include <immintrin.h>
+
+namespace
+{
+	struct v256 { __m256i v; };
+
+	inline v256 operator&(v256 a, v256 b) { return { _mm256_and_si256(a.v, b.v) }; }
+	inline v256 operator|(v256 a, v256 b) { return { _mm256_or_si256 (a.v, b.v) }; }
+	inline v256 operator^(v256 a, v256 b) { return { _mm256_xor_si256(a.v, b.v) }; }
+	inline v256 operator~(v256 a) { return { _mm256_xor_si256(a.v, _mm256_set1_epi32(-1)) }; }
+	inline v256 operator<<(v256 a, int bits) { return { _mm256_slli_epi64(a.v, bits) }; }
+	inline v256 operator>>(v256 a, int bits) { return { _mm256_srli_epi64(a.v, bits) }; }
+
+	template <>
+	struct reg_traits<v256>
+	{
+		static constexpr size_t words = 4;
+		static v256 load(const uint64_t* src) { return { _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src)) }; }
+		static void store(uint64_t* dst, v256 value) { _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst), value.v); }
+		static v256 broadcast(uint64_t value) { return { _mm256_set1_epi64x(static_cast<long long>(value)) }; }
+		static v256 add(v256 a, v256 b) { return { _mm256_add_epi64(a.v, b.v) }; }
+		// The low 64 bits of the product, from three 32 by 32 bit products.
+		static v256 multiply(v256 a, v256 b)
+		{
+			__m256i cross = _mm256_add_epi64(_mm256_mul_epu32(_mm256_srli_epi64(a.v, 32), b.v), _mm256_mul_epu32(a.v, _mm256_srli_epi64(b.v, 32)));
+			return { _mm256_add_epi64(_mm256_mul_epu32(a.v, b.v), _mm256_slli_epi64(cross, 32)) };
+		}
+		static bool all_ones(v256 value) { return _mm256_movemask_epi8(_mm256_cmpeq_epi64(value.v, _mm256_set1_epi32(-1))) == -1; }
+	};
+}
+
+void grid_step_block_avx2(const Grid* grid, size_t y_begin, size_t y_end, size_t word_begin, size_t word_end, uint64_t* changes, grid_tile_stats* stats)
+{
+	step_block<v256>(grid, y_begin, y_end, word_begin, word_end, changes, stats);
+	_mm256_zeroupper();
+}
+
+void batch_step_avx2(const Batch* batch, uint64_t* changed, uint64_t* differs)
+{
+	step_batch<v256>(batch, changed, differs);
+	_mm256_zeroupper();
+}
+
+void grid_randomize_words_avx2(uint64_t* words, size_t count, uint64_t key, uint64_t first_word, uint32_t threshold)
+{
+	randomize_words<v256>(words, count, key, first_word, threshold);
+	_mm256_zeroupper();
+}
+#else
+void grid_step_block_avx2(const Grid* grid, size_t y_begin, size_t y_end, size_t word_begin, size_t word_end, uint64_t* changes, grid_tile_stats* stats)
+{
+	step_block<uint64_t>(grid, y_begin, y_end, word_begin, word_end, changes, stats);
+}
+
+void batch_step_avx2(const Batch* batch, uint64_t* changed, uint64_t* differs)
+{
+	step_batch<uint64_t>(batch, changed, differs);
+}
+
+void grid_randomize_words_avx2(uint64_t* words, size_t count, uint64_t key, uint64_t first_word, uint32_t threshold)
+{
+	randomize_words<uint64_t>(words, count, key, first_word, threshold);
+}
+#endif
@@ -0,0 +1,71 @@
+// Compiled with AVX-512 enabled (/arch:AVX512, -mavx512f). Only called when
+// kernel_isa_detect() reports AVX-512 support.
+#include <grid_kernel.hpp>
+#include <grid_kernel_impl.hpp>
+
+#if defined(_M_X64) || defined(__x86_64__)
+#include <immintrin.h>
+
+namespace
+{
+	struct v512 { __m512i v; };
+
+	inline v512 operator&(v512 a, v512 b) { return { _mm512_and_si512(a.v, b.v) }; }
+	inline v512 operator|(v512 a, v512 b) { return { _mm512_or_si512 (a.v, b.v) }; }
+	inline v512 operator^(v512 a, v512 b) { return { _mm512_xor_si512(a.v, b.v) }; }
+	inline v512 operator~(v512 a) { return { _mm512_xor_si512(a.v, _mm512_set1_epi32(-1)) }; }
+	inline v512 operator<<(v512 a, int bits) { return { _mm512_slli_epi64(a.v, bits) }; }
+	inline v512 operator>>(v512 a, int bits) { return { _mm512_srli_epi64(a.v, bits) }; }
+
+	template <>
+	struct reg_traits<v512>
+	{
+		static constexpr size_t words = 8;
+		static v512 load(const uint64_t* src) { return { _mm512_loadu_si512(src) }; }
+		static void store(uint64_t* dst, v512 value) { _mm512_storeu_si512(dst, value.v); }
+		static v512 broadcast(uint64_t value) { return { _mm512_set1_epi64(static_cast<long long>(value)) }; }
+		static v512 add(v512 a, v512 b) { return { _mm512_add_epi64(a.v, b.v) }; }
+		// The low 64 bits of the product, from three 32 by 32 bit products:
+		// AVX-512F has no 64-bit multiply of its own, that is AVX-512DQ.
+		static v512 multiply(v512 a, v512 b)
+		{
+			__m512i cross = _mm512_add_epi64(_mm512_mul_epu32(_mm512_srli_epi64(a.v, 32), b.v), _mm512_mul_epu32(a.v, _mm512_srli_epi64(b.v, 32)));
+			return { _mm512_add_epi64(_mm512_mul_epu32(a.v, b.v), _mm512_slli_epi64(cross, 32)) };
+		}
+		static bool all_ones(v512 value) { return _mm512_cmpeq_epi64_mask(value.v, _mm512_set1_epi32(-1)) == 0xff; }
+	};
+}
+
+void grid_step_block_avx512(const Grid* grid, size_t y_begin, size_t y_end, size_t word_begin, size_t word_end, uint64_t* changes, grid_tile_stats* stats)
+{
+	step_block<v512>(grid, y_begin, y_end, word_begin, word_end, changes, stats);
+	_mm256_zeroupper();
+}
+
+void batch_step_avx512(const Batch* batch, uint64_t* changed, uint64_t* differs)
+{
+	step_batch<v512>(batch, changed, differs);
+	_mm256_zeroupper();
+}
+
+void grid_randomize_words_avx512(uint64_t* words, size_t count, uint64_t key, uint64_t first_word, uint32_t threshold)
+{
+	randomize_words<v512>(words, count, key, first_word, threshold);
+	_mm256_zeroupper();
+}
+#else
+void grid_step_block_avx512(const Grid* grid, size_t y_begin, size_t y_end, size_t word_begin, size_t word_end, uint64_t* changes, grid_tile_stats* stats)
+{
+	step_block<uint64_t>(grid, y_begin, y_end, word_begin, word_end, changes, stats);
+}
+
+void batch_step_avx512(const Batch* batch, uint64_t* changed, uint64_t* differs)
+{
+	step_batch<uint64_t>(batch, changed, differs);
+}
+
+void grid_randomize_words_avx512(uint64_t* words, size_t count, uint64_t key, uint64_t first_word, uint32_t threshold)
+{
+	randomize_words<uint64_t>(words, count, key, first_word, threshold);
+}
+#endif
@@ -0,0 +1,142 @@
+#include <grid_png.hpp>
+#include <lodepng/lodepng.hpp>
+#include <algorithm>
+#include <vector>
+#include <stdlib.h>
+#include <string.h>
+
+namespace
+{
+	// A grid keeps cell x in bit x % 8 of its byte, PNG keeps pixel x in bit
+	// 7 - x % 8. Reversing the bits of every byte turns one into the other, both
+	// ways. Words are little endian, so their bytes are in cell order already.
+	uint64_t swap_bit_order(uint64_t word)
+	{
+		word = ((word >> 1) & 0x5555555555555555) | ((word & 0x5555555555555555) << 1);
+		word = ((word >> 2) & 0x3333333333333333) | ((word & 0x3333333333333333) << 2);
+		word = ((word >> 4) & 0x0f0f0f0f0f0f0f0f) | ((word & 0x0f0f0f0f0f0f0f0f) << 4);
+		return word;
+	}
+
+	// The 64 bits of row from bit offset on, zero outside of the row.
+	uint64_t bits_at(const uint64_t* row, size_t word_count, int64_t offset)
+	{
+		const int64_t i = offset >> 6;
+		const int64_t shift = offset & 63;
+		uint64_t low = i >= 0 && i < static_cast<int64_t>(word_count) ? row[i] : 0;
+		if (shift == 0) return low;
+		uint64_t high = i + 1 >= 0 && i + 1 < static_cast<int64_t>(word_count) ? row[i + 1] : 0;
+		return low >> shift | high << (64 - shift);
+	}
+
+	void set_grey_1(LodePNGColorMode* color)
+	{
+		color->colortype = LCT_GREY;
+		color->bitdepth = 1;
+	}
+
+	// Decodes png to one bit per pixel, the rows one after the other in cell bit
+	// order. lodepng only converts grey to 1-bit grey, so anything else is decoded
+	// to RGBA and thresholded here.
+	bool decode_cells(const unsigned char* png, size_t png_size, unsigned* width, unsigned* height, std::vector<uint64_t>* pixels)
+	{
+		LodePNGState state;
+		lodepng_state_init(&state);
+		unsigned error = lodepng_inspect(width, height, &state, png, png_size);
+		const bool grey_1 = error == 0 && state.info_png.color.colortype == LCT_GREY && state.info_png.color.bitdepth == 1;
+		if (grey_1) set_grey_1(&state.info_raw);
+		unsigned char* image = nullptr;
+		if (error == 0) error = lodepng_decode(&image, width, height, &state, png, png_size);
+		lodepng_state_cleanup(&state);
+		if (error != 0) {
+			free(image);
+			return false;
+		}
+
+		const size_t bit_count = static_cast<size_t>(*width) * *height;
+		pixels->assign((bit_count + 63) / 64, 0);
+		if (grey_1) {
+			memcpy(pixels->data(), image, (bit_count + 7) / 8);
+			for (uint64_t& word : *pixels)
+				word = swap_bit_order(word);
+		}
+		else {
+			// Alive when at least half bright and half opaque.
+			for (size_t i = 0; i < bit_count; ++i) {
+				const unsigned char* rgba = image + i * 4;
+				const bool alive = rgba[0] + rgba[1] + rgba[2] >= 3 * 128 && rgba[3] >= 128;
+				(*pixels)[i / 64] |= uint64_t(alive) << (i % 64);
+			}
+		}
+		free(image);
+		return true;
+	}
+}
+
+bool grid_save_png(const Grid* grid, const char* path) {
+	if (grid->width_ > UINT32_MAX || grid->height_ > UINT32_MAX) return false;
+
+	// lodepng wants the rows of images under 8 bits per pixel one after the other,
+	// not padded to whole bytes: row y starts at bit y * width.
+	const size_t width = grid->width_;
+	std::vector<uint64_t> image((width * grid->height_ + 63) / 64 + 1, 0);
+	for (size_t y = 0; y < grid->height_; ++y) {
+		const uint64_t* row = grid->cells_ + y * grid->stride_;
+		const size_t shift = y * width % 64;
+		uint64_t* pixels = image.data() + y * width / 64;
+		for (size_t i = 0; i < grid->words_per_row_; ++i) {
+			pixels[i] |= row[i] << shift;
+			if (shift != 0) pixels[i + 1] |= row[i] >> (64 - shift);
+		}
+	}
+	for (uint64_t& word : image)
+		word = swap_bit_order(word);
+
+	LodePNGState state;
+	lodepng_state_init(&state);
+	set_grey_1(&state.info_raw);
+	set_grey_1(&state.info_png.color);
+	state.encoder.auto_convert = 0;
+	unsigned char* png = nullptr;
+	size_t png_size = 0;
+	unsigned error = lodepng_encode(&png, &png_size, reinterpret_cast<const unsigned char*>(image.data()),
+		static_cast<unsigned>(width), static_cast<unsigned>(grid->height_), &state);
+	if (error == 0) error = lodepng_save_file(png, png_size, path);
+	free(png);
+	lodepng_state_cleanup(&state);
+	return error == 0;
+}
+
+bool grid_load_png(Grid* grid, const char* path, int64_t x, int64_t y) {
+	unsigned char* png = nullptr;
+	size_t png_size = 0;
+	if (lodepng_load_file(&png, &png_size, path) != 0) {
+		free(png);
+		return false;
+	}
+	unsigned width = 0, height = 0;
+	std::vector<uint64_t> pixels;
+	const bool decoded = decode_cells(png, png_size, &width, &height, &pixels);
+	free(png);
+	if (!decoded) return false;
+
+	// Only the columns [begin, end) of the grid are covered by the image.
+	const int64_t begin = std::max<int64_t>(x, 0);
+	const int64_t end = std::min<int64_t>(x + width, static_cast<int64_t>(grid->width_));
+	for (unsigned image_y = 0; image_y < height && begin < end; ++image_y) {
+		const int64_t grid_y = y + image_y;
+		if (grid_y < 0 || grid_y >= static_cast<int64_t>(grid->height_)) continue;
+
+		const int64_t row_offset = static_cast<int64_t>(image_y) * width - x;
+		uint64_t* row = grid->cells_ + grid_y * grid->stride_;
+		for (int64_t i = begin / 64; i <= (end - 1) / 64; ++i) {
+			int64_t word_begin = std::max(begin, i * 64) - i * 64;
+			int64_t word_end = std::min(end, i * 64 + 64) - i * 64;
+			uint64_t mask = ~uint64_t(0) << word_begin;
+			if (word_end < 64) mask &= (uint64_t(1) << word_end) - 1;
+			row[i] = (row[i] & ~mask) | (bits_at(pixels.data(), pixels.size(), row_offset + i * 64) & mask);
+		}
+	}
+	grid_mark_changed(grid);
+	return true;
+}
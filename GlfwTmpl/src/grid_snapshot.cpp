@@ -0,0 +1,312 @@
+#include <grid_snapshot.hpp>
+#include <thread_pool.hpp>
+#include <lodepng/lodepng.hpp>
+#include <atomic>
+#include <string>
+#include <vector>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#if defined(_WIN32)
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+/** A snapshot file mapped into memory. */
+struct grid_mapping
+{
+	void* view_;
+	size_t size_;
+};
+
+namespace
+{
+	static_assert(sizeof(GridSnapshotHeader) <= grid_snapshot_data_offset);
+
+	// The longest side of a board a snapshot may have: 2^40 cells.
+	constexpr uint64_t max_side = uint64_t(1) << 40;
+
+	// Maps all of path copy-on-write: writes to the view never reach the file.
+	grid_mapping* map_file(const char* path)
+	{
+#if defined(_WIN32)
+		HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+		if (file == INVALID_HANDLE_VALUE) return nullptr;
+		LARGE_INTEGER size;
+		void* view = nullptr;
+		if (GetFileSizeEx(file, &size) && size.QuadPart > 0) {
+			HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_WRITECOPY, 0, 0, nullptr);
+			if (mapping != nullptr) {
+				// The view keeps the mapping, and the file, open.
+				view = MapViewOfFile(mapping, FILE_MAP_COPY, 0, 0, 0);
+				CloseHandle(mapping);
+			}
+		}
+		CloseHandle(file);
+		if (view == nullptr) return nullptr;
+		return new grid_mapping{ .view_ = view, .size_ = static_cast<size_t>(size.QuadPart) };
+#else
+		int file = open(path, O_RDONLY);
+		if (file < 0) return nullptr;
+		struct stat status;
+		void* view = MAP_FAILED;
+		if (fstat(file, &status) == 0 && status.st_size > 0)
+			view = mmap(nullptr, static_cast<size_t>(status.st_size), PROT_READ | PROT_WRITE, MAP_PRIVATE, file, 0);
+		close(file);
+		if (view == MAP_FAILED) return nullptr;
+		return new grid_mapping{ .view_ = view, .size_ = static_cast<size_t>(status.st_size) };
+#endif
+	}
+
+	bool replace_file(const char* from, const char* to)
+	{
+#if defined(_WIN32)
+		return MoveFileExA(from, to, MOVEFILE_REPLACE_EXISTING) != 0;
+#else
+		return rename(from, to) == 0;
+#endif
+	}
+
+	bool header_valid(const GridSnapshotHeader& header, size_t file_size)
+	{
+		if (memcmp(header.magic_, grid_snapshot_magic, sizeof header.magic_) != 0) return false;
+		if (header.version_ == 0 || header.version_ > grid_snapshot_version) return false;
+		if (header.data_offset_ < sizeof header || header.data_offset_ % sizeof(uint64_t) != 0) return false;
+		if (header.width_ == 0 || header.height_ == 0) return false;
+		// Far past any board that fits in memory, and small enough for the sums below not to wrap.
+		if (header.width_ > max_side || header.height_ > max_side) return false;
+		if (header.stride_ != (header.width_ + 63) / 64 + 2) return false;
+		// B0 rules are not supported by the kernel, see rule_parse.
+		if (header.birth_ > 0x1ff || header.survival_ > 0x1ff || (header.birth_ & 1) != 0) return false;
+		if (header.boundary_ > static_cast<uint32_t>(grid_boundary::klein_bottle)) return false;
+		if (header.data_offset_ > file_size || header.data_size_ > file_size - header.data_offset_) return false;
+
+		const uint64_t rows = header.height_ + 2;
+		if (header.stride_ > SIZE_MAX / sizeof(uint64_t) / rows) return false;
+		switch (static_cast<grid_snapshot_compression>(header.compression_))
+		{
+		case grid_snapshot_compression::none:
+			return header.data_size_ == header.stride_ * rows * sizeof(uint64_t);
+		case grid_snapshot_compression::deflate:
+			return header.data_size_ / sizeof(uint64_t) >= (header.height_ + grid_tile_size - 1) / grid_tile_size;
+		}
+		return false;
+	}
+
+	GridSnapshotHeader make_header(const Grid* grid, grid_snapshot_compression compression, uint64_t data_size)
+	{
+		GridSnapshotHeader header = {
+			.magic_ = {},
+			.version_ = grid_snapshot_version,
+			.data_offset_ = grid_snapshot_data_offset,
+			.width_ = grid->width_,
+			.height_ = grid->height_,
+			.stride_ = grid->stride_,
+			.generation_ = grid->generation_,
+			.birth_ = grid->rule_.birth_,
+			.survival_ = grid->rule_.survival_,
+			.boundary_ = static_cast<uint32_t>(grid->boundary_),
+			.compression_ = static_cast<uint32_t>(compression),
+			.data_size_ = data_size,
+		};
+		memcpy(header.magic_, grid_snapshot_magic, sizeof header.magic_);
+		return header;
+	}
+
+	struct piece
+	{
+		const void* data_;
+		size_t size_;
+	};
+
+	// Writes the header page and then every piece in one go. A grid restored from
+	// path has to let go of it first, see grid_release_mapping: Windows does not
+	// replace a mapped file.
+	bool write_snapshot(const char* path, const GridSnapshotHeader& header, const std::vector<piece>& pieces)
+	{
+		char page[grid_snapshot_data_offset] = {};
+		memcpy(page, &header, sizeof header);
+
+		std::string temp_path = std::string(path) + ".tmp";
+		FILE* file = fopen(temp_path.c_str(), "wb");
+		if (file == nullptr) return false;
+		bool ok = fwrite(page, sizeof page, 1, file) == 1;
+		for (const piece& data : pieces)
+			ok = ok && (data.size_ == 0 || fwrite(data.data_, 1, data.size_, file) == data.size_);
+		ok = fclose(file) == 0 && ok;
+		if (ok) ok = replace_file(temp_path.c_str(), path);
+		if (!ok) remove(temp_path.c_str());
+		return ok;
+	}
+
+	// The rows of tile row i, from the left halo word of its first row.
+	uint64_t* tile_row_words(const Grid* grid, size_t i, size_t* word_count)
+	{
+		size_t y_begin = i * grid_tile_size;
+		size_t y_end = y_begin + grid_tile_size < grid->height_ ? y_begin + grid_tile_size : grid->height_;
+		*word_count = (y_end - y_begin) * grid->stride_;
+		return grid->cells_ + y_begin * grid->stride_ - 1;
+	}
+
+	// Calls task for every tile row, on the thread pool of grid or on a pool of
+	// every hardware thread. Tile rows are handed out one at a time, as dense
+	// ones take far longer to (de)compress than empty ones.
+	template <typename task_type>
+	void for_each_tile_row(const Grid* grid, const task_type& task)
+	{
+		thread_pool* pool = grid->pool_;
+		thread_pool own_pool(pool == nullptr ? 0 : 1);
+		if (pool == nullptr) pool = &own_pool;
+
+		std::atomic<size_t> next_tile_row = 0;
+		pool->run(1, [&](size_t) {
+			for (size_t i = next_tile_row++; i < grid->tile_rows_; i = next_tile_row++)
+				task(i);
+		}, [] {});
+	}
+
+	bool inflate_tile_rows(Grid* grid, const uint8_t* data, uint64_t data_size)
+	{
+		// Every stream has to lie within the data; checked up front, so the
+		// threads only have to check what comes out.
+		const size_t tile_rows = grid->tile_rows_;
+		const uint8_t* streams = data + tile_rows * sizeof(uint64_t);
+		std::vector<uint64_t> offsets(tile_rows + 1, 0);
+		uint64_t available = data_size - tile_rows * sizeof(uint64_t);
+		for (size_t i = 0; i < tile_rows; ++i) {
+			uint64_t size;
+			memcpy(&size, data + i * sizeof(uint64_t), sizeof size);
+			if (size > available - offsets[i]) return false;
+			offsets[i + 1] = offsets[i] + size;
+		}
+
+		std::atomic<bool> ok = true;
+		for_each_tile_row(grid, [&](size_t i) {
+			// The grid starts out empty, so empty tile rows are done already.
+			if (offsets[i + 1] == offsets[i]) return;
+			size_t word_count;
+			uint64_t* words = tile_row_words(grid, i, &word_count);
+			unsigned char* out = nullptr;
+			size_t out_size = 0;
+			unsigned error = lodepng_zlib_decompress(&out, &out_size, streams + offsets[i],
+				static_cast<size_t>(offsets[i + 1] - offsets[i]), &lodepng_default_decompress_settings);
+			if (error == 0 && out_size == word_count * sizeof(uint64_t)) memcpy(words, out, out_size);
+			else ok = false;
+			free(out);
+		});
+		return ok;
+	}
+}
+
+bool grid_save_snapshot(const Grid* grid, const char* path) {
+	const size_t word_count = grid->stride_ * (grid->height_ + 2);
+	const size_t size = word_count * sizeof(uint64_t);
+	GridSnapshotHeader header = make_header(grid, grid_snapshot_compression::none, size);
+	return write_snapshot(path, header, { { grid->cells_ - grid->stride_ - 1, size } });
+}
+
+bool grid_save_compressed_snapshot(const Grid* grid, const char* path) {
+	const size_t tile_rows = grid->tile_rows_;
+	std::vector<unsigned char*> streams(tile_rows, nullptr);
+	std::vector<uint64_t> sizes(tile_rows, 0);
+	std::atomic<bool> ok = true;
+	for_each_tile_row(grid, [&](size_t i) {
+		size_t word_count;
+		const uint64_t* words = tile_row_words(grid, i, &word_count);
+		uint64_t any = 0;
+		for (size_t j = 0; j < word_count; ++j)
+			any |= words[j];
+		if (any == 0) return;
+
+		size_t size = 0;
+		if (lodepng_zlib_compress(&streams[i], &size, reinterpret_cast<const unsigned char*>(words),
+			word_count * sizeof(uint64_t), &lodepng_default_compress_settings) != 0) ok = false;
+		sizes[i] = size;
+	});
+
+	if (ok) {
+		std::vector<piece> pieces = { { sizes.data(), tile_rows * sizeof(uint64_t) } };
+		uint64_t data_size = tile_rows * sizeof(uint64_t);
+		for (size_t i = 0; i < tile_rows; ++i) {
+			pieces.push_back({ streams[i], static_cast<size_t>(sizes[i]) });
+			data_size += sizes[i];
+		}
+		ok = write_snapshot(path, make_header(grid, grid_snapshot_compression::deflate, data_size), pieces);
+	}
+	for (unsigned char* stream : streams)
+		free(stream);
+	return ok;
+}
+
+bool grid_load_snapshot(Grid* grid, const char* path) {
+	grid_mapping* mapping = map_file(path);
+	if (mapping == nullptr) return false;
+
+	GridSnapshotHeader header;
+	if (mapping->size_ < sizeof header) {
+		grid_mapping_release(mapping);
+		return false;
+	}
+	memcpy(&header, mapping->view_, sizeof header);
+	if (!header_valid(header, mapping->size_)) {
+		grid_mapping_release(mapping);
+		return false;
+	}
+
+	const auto data = static_cast<const uint8_t*>(mapping->view_) + header.data_offset_;
+	const size_t width = static_cast<size_t>(header.width_);
+	const size_t height = static_cast<size_t>(header.height_);
+	Grid restored;
+	if (static_cast<grid_snapshot_compression>(header.compression_) == grid_snapshot_compression::none) {
+		auto buffer = reinterpret_cast<uint64_t*>(const_cast<uint8_t*>(data));
+		restored = grid_init_mapped(width, height, buffer, mapping);
+		if (restored.memory_ == nullptr) {
+			grid_mapping_release(mapping);
+			return false;
+		}
+	}
+	else {
+		// Empty tile rows take no room in the file, so the size of the board is not
+		// bounded by it: a board too large to allocate is not restored either.
+		restored = grid_init_mapped(width, height, nullptr, nullptr);
+		if (restored.memory_ == nullptr) {
+			grid_mapping_release(mapping);
+			return false;
+		}
+		restored.pool_ = grid->pool_;
+		bool ok = inflate_tile_rows(&restored, data, header.data_size_);
+		restored.pool_ = nullptr;
+		grid_mapping_release(mapping);
+		if (!ok) {
+			grid_free(&restored);
+			return false;
+		}
+	}
+	restored.rule_ = { .birth_ = header.birth_, .survival_ = header.survival_ };
+	restored.boundary_ = static_cast<grid_boundary>(header.boundary_);
+	restored.generation_ = header.generation_;
+	// The other buffer is empty, so the first generation steps every tile.
+	grid_mark_changed(&restored);
+
+	if (grid->tile_stats_ != nullptr) grid_track_stats(&restored, true);
+	if (grid->tile_hashes_ != nullptr) grid_track_hashes(&restored, true);
+	restored.pool_ = grid->pool_;
+	grid->pool_ = nullptr;
+	grid_free(grid);
+	*grid = restored;
+	return true;
+}
+
+void grid_mapping_release(grid_mapping* mapping) {
+#if defined(_WIN32)
+	UnmapViewOfFile(mapping->view_);
+#else
+	munmap(mapping->view_, mapping->size_);
+#endif
+	delete mapping;
+}
@@ -0,0 +1,586 @@
+#include <hashlife.hpp>
+#include <algorithm>
+#include <string>
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+namespace
+{
+	// Level 0 nodes. They are not in the table, so 0 also marks a free slot.
+	constexpr uint32_t dead_cell = 0;
+	constexpr uint32_t live_cell = 1;
+
+	// Keeps every coordinate of the root within int64_t.
+	constexpr uint32_t max_level = 62;
+	constexpr uint32_t min_root_level = 3;
+	constexpr size_t min_collect_threshold = size_t(1) << 22;
+
+	uint64_t hash_children(uint32_t nw, uint32_t ne, uint32_t sw, uint32_t se)
+	{
+		uint64_t hash = nw * 0x9e3779b97f4a7c15ull;
+		hash = (hash ^ ne) * 0xbf58476d1ce4e5b9ull;
+		hash = (hash ^ sw) * 0x94d049bb133111ebull;
+		hash = (hash ^ se) * 0x9e3779b97f4a7c15ull;
+		return hash ^ (hash >> 29);
+	}
+
+	void table_insert(HashLife* life, uint32_t index)
+	{
+		const hashlife_node& node = life->nodes_[index];
+		size_t mask = life->table_.size() - 1;
+		size_t slot = hash_children(node.nw_, node.ne_, node.sw_, node.se_) & mask;
+		while (life->table_[slot] != 0) slot = (slot + 1) & mask;
+		life->table_[slot] = index;
+	}
+
+	void rebuild_table(HashLife* life, size_t slot_count)
+	{
+		life->table_.assign(slot_count, 0);
+		for (uint32_t i = live_cell + 1; i < life->nodes_.size(); ++i)
+			table_insert(life, i);
+	}
+
+	// Populations beyond 2^64 stick at the maximum rather than wrapping to zero,
+	// which would make the node look empty.
+	uint64_t add_population(uint64_t a, uint64_t b)
+	{
+		return a + b < a ? UINT64_MAX : a + b;
+	}
+
+	uint32_t join(HashLife* life, uint32_t nw, uint32_t ne, uint32_t sw, uint32_t se)
+	{
+		size_t mask = life->table_.size() - 1;
+		size_t slot = hash_children(nw, ne, sw, se) & mask;
+		for (uint32_t index; (index = life->table_[slot]) != 0; slot = (slot + 1) & mask) {
+			const hashlife_node& node = life->nodes_[index];
+			if (node.nw_ == nw && node.ne_ == ne && node.sw_ == sw && node.se_ == se)
+				return index;
+		}
+
+		const std::vector<hashlife_node>& nodes = life->nodes_;
+		hashlife_node node = {
+			.nw_ = nw, .ne_ = ne, .sw_ = sw, .se_ = se,
+			.result_ = hashlife_no_node,
+			.level_ = static_cast<uint16_t>(nodes[nw].level_ + 1),
+			.result_log2_ = 0,
+			.population_ = add_population(add_population(nodes[nw].population_, nodes[ne].population_),
+				add_population(nodes[sw].population_, nodes[se].population_)),
+		};
+		assert(nodes.size() < hashlife_no_node);
+		uint32_t index = static_cast<uint32_t>(nodes.size());
+		life->nodes_.push_back(node);
+
+		// Keep the table at most half full.
+		if (life->nodes_.size() * 2 > life->table_.size())
+			rebuild_table(life, life->table_.size() * 2);
+		else
+			life->table_[slot] = index;
+		return index;
+	}
+
+	uint32_t empty(HashLife* life, uint32_t level)
+	{
+		while (life->empty_.size() <= level) {
+			uint32_t below = life->empty_.back();
+			life->empty_.push_back(join(life, below, below, below, below));
+		}
+		return life->empty_[level];
+	}
+
+	uint32_t expand(HashLife* life, uint32_t node)
+	{
+		hashlife_node n = life->nodes_[node];
+		assert(n.level_ < max_level);
+		uint32_t e = empty(life, n.level_ - 1);
+		return join(life,
+			join(life, e, e, e, n.nw_), join(life, e, e, n.ne_, e),
+			join(life, e, n.sw_, e, e), join(life, n.se_, e, e, e));
+	}
+
+	// True if nothing is alive outside of centre(centre(node)). Checked on the
+	// nodes around it rather than by comparing populations, which saturate.
+	bool only_centre_alive(const HashLife* life, uint32_t node)
+	{
+		const std::vector<hashlife_node>& nodes = life->nodes_;
+		const hashlife_node& n = nodes[node];
+		const hashlife_node& nw = nodes[n.nw_];
+		const hashlife_node& ne = nodes[n.ne_];
+		const hashlife_node& sw = nodes[n.sw_];
+		const hashlife_node& se = nodes[n.se_];
+		// Of every quadrant, only the corner that touches the centre may be alive.
+		const hashlife_node& nw_se = nodes[nw.se_];
+		const hashlife_node& ne_sw = nodes[ne.sw_];
+		const hashlife_node& sw_ne = nodes[sw.ne_];
+		const hashlife_node& se_nw = nodes[se.nw_];
+		const uint32_t outside[24] = {
+			nw.nw_, nw.ne_, nw.sw_, nw_se.nw_, nw_se.ne_, nw_se.sw_,
+			ne.nw_, ne.ne_, ne.se_, ne_sw.nw_, ne_sw.ne_, ne_sw.se_,
+			sw.nw_, sw.sw_, sw.se_, sw_ne.nw_, sw_ne.sw_, sw_ne.se_,
+			se.ne_, se.sw_, se.se_, se_nw.ne_, se_nw.sw_, se_nw.se_,
+		};
+		for (uint32_t quadrant : outside) {
+			if (nodes[quadrant].population_ != 0) return false;
+		}
+		return true;
+	}
+
+	uint32_t centre(HashLife* life, uint32_t node)
+	{
+		hashlife_node n = life->nodes_[node];
+		const std::vector<hashlife_node>& nodes = life->nodes_;
+		return join(life, nodes[n.nw_].se_, nodes[n.ne_].sw_, nodes[n.sw_].ne_, nodes[n.se_].nw_);
+	}
+
+	// The node straddling the border between two nodes next to each other.
+	uint32_t centre_horizontal(HashLife* life, uint32_t west, uint32_t east)
+	{
+		hashlife_node w = life->nodes_[west];
+		hashlife_node e = life->nodes_[east];
+		return join(life, w.ne_, e.nw_, w.se_, e.sw_);
+	}
+
+	// The node straddling the border between two nodes above each other.
+	uint32_t centre_vertical(HashLife* life, uint32_t north, uint32_t south)
+	{
+		hashlife_node n = life->nodes_[north];
+		hashlife_node s = life->nodes_[south];
+		return join(life, n.sw_, n.se_, s.nw_, s.ne_);
+	}
+
+	bool cell_at(const HashLife* life, uint32_t node, uint32_t level, uint64_t x, uint64_t y)
+	{
+		while (level > 0) {
+			const hashlife_node& n = life->nodes_[node];
+			uint64_t half = uint64_t(1) << --level;
+			bool east = x >= half;
+			bool south = y >= half;
+			node = south ? (east ? n.se_ : n.sw_) : (east ? n.ne_ : n.nw_);
+			x -= east ? half : 0;
+			y -= south ? half : 0;
+		}
+		return node == live_cell;
+	}
+
+	// Steps the centre 2x2 cells of a 4x4 node by one generation.
+	uint32_t base_result(HashLife* life, uint32_t node)
+	{
+		uint32_t cells = 0;
+		for (uint32_t y = 0; y < 4; ++y) {
+			for (uint32_t x = 0; x < 4; ++x) {
+				cells |= static_cast<uint32_t>(cell_at(life, node, 2, x, y)) << (y * 4 + x);
+			}
+		}
+
+		uint32_t next[4];
+		for (uint32_t i = 0; i < 4; ++i) {
+			uint32_t x = 1 + i % 2;
+			uint32_t y = 1 + i / 2;
+			uint32_t alive_neighbours_count = 0;
+			for (uint32_t ny = y - 1; ny <= y + 1; ++ny) {
+				for (uint32_t nx = x - 1; nx <= x + 1; ++nx) {
+					alive_neighbours_count += (cells >> (ny * 4 + nx)) & 1;
+				}
+			}
+			bool alive = (cells >> (y * 4 + x)) & 1;
+			alive_neighbours_count -= alive;
+			uint32_t rule_mask = alive ? life->rule_.survival_ : life->rule_.birth_;
+			next[i] = (rule_mask >> alive_neighbours_count) & 1 ? live_cell : dead_cell;
+		}
+		return join(life, next[0], next[1], next[2], next[3]);
+	}
+
+	// Returns the centre half of node after 2^min(level - 2, step_log2_) generations.
+	uint32_t successor(HashLife* life, uint32_t node)
+	{
+		hashlife_node n = life->nodes_[node];
+		// Nodes up to two levels above the step advance as far as they can whatever
+		// it is, so their results survive a change of step; the others recompute.
+		const uint16_t result_log2 = static_cast<uint16_t>(std::min<uint32_t>(n.level_ - 2, life->step_log2_));
+		if (n.result_ != hashlife_no_node && n.result_log2_ == result_log2) return n.result_;
+
+		uint32_t result;
+		if (n.population_ == 0) {
+			result = empty(life, n.level_ - 1);
+		}
+		else if (n.level_ == 2) {
+			result = base_result(life, node);
+		}
+		else {
+			// Nine overlapping sub-squares of half the size...
+			uint32_t n00 = n.nw_;
+			uint32_t n01 = centre_horizontal(life, n.nw_, n.ne_);
+			uint32_t n02 = n.ne_;
+			uint32_t n10 = centre_vertical(life, n.nw_, n.sw_);
+			uint32_t n11 = centre(life, node);
+			uint32_t n12 = centre_vertical(life, n.ne_, n.se_);
+			uint32_t n20 = n.sw_;
+			uint32_t n21 = centre_horizontal(life, n.sw_, n.se_);
+			uint32_t n22 = n.se_;
+
+			// ...are advanced by half the step, or not at all when the step is less
+			// than the node could do...
+			const bool full_speed = life->step_log2_ >= n.level_ - 2;
+			auto first_half = [&](uint32_t sub) { return full_speed ? successor(life, sub) : centre(life, sub); };
+			uint32_t r00 = first_half(n00), r01 = first_half(n01), r02 = first_half(n02);
+			uint32_t r10 = first_half(n10), r11 = first_half(n11), r12 = first_half(n12);
+			uint32_t r20 = first_half(n20), r21 = first_half(n21), r22 = first_half(n22);
+
+			// ...and combined into four squares that are advanced by the rest.
+			uint32_t nw = successor(life, join(life, r00, r01, r10, r11));
+			uint32_t ne = successor(life, join(life, r01, r02, r11, r12));
+			uint32_t sw = successor(life, join(life, r10, r11, r20, r21));
+			uint32_t se = successor(life, join(life, r11, r12, r21, r22));
+			result = join(life, nw, ne, sw, se);
+		}
+		life->nodes_[node].result_ = result;
+		life->nodes_[node].result_log2_ = result_log2;
+		return result;
+	}
+
+	uint32_t set_cell(HashLife* life, uint32_t node, uint32_t level, uint64_t x, uint64_t y, bool alive)
+	{
+		if (level == 0) return alive ? live_cell : dead_cell;
+
+		hashlife_node n = life->nodes_[node];
+		uint64_t half = uint64_t(1) << (level - 1);
+		bool east = x >= half;
+		bool south = y >= half;
+		x -= east ? half : 0;
+		y -= south ? half : 0;
+		if (south) {
+			if (east) n.se_ = set_cell(life, n.se_, level - 1, x, y, alive);
+			else      n.sw_ = set_cell(life, n.sw_, level - 1, x, y, alive);
+		}
+		else {
+			if (east) n.ne_ = set_cell(life, n.ne_, level - 1, x, y, alive);
+			else      n.nw_ = set_cell(life, n.nw_, level - 1, x, y, alive);
+		}
+		return join(life, n.nw_, n.ne_, n.sw_, n.se_);
+	}
+
+	bool root_contains(const HashLife* life, int64_t x, int64_t y)
+	{
+		int64_t half = int64_t(1) << (life->nodes_[life->root_].level_ - 1);
+		return x >= -half && x < half && y >= -half && y < half;
+	}
+
+	// Builds the node covering [x, x + 2^level) x [y, y + 2^level) of the grid.
+	uint32_t build_from_grid(HashLife* life, const Grid* grid, uint32_t level, int64_t x, int64_t y)
+	{
+		const int64_t size = int64_t(1) << level;
+		if (x + size <= 0 || y + size <= 0 ||
+			x >= static_cast<int64_t>(grid->width_) || y >= static_cast<int64_t>(grid->height_))
+			return empty(life, level);
+		if (level == 0)
+			return get_cell(grid, static_cast<size_t>(x), static_cast<size_t>(y)) ? live_cell : dead_cell;
+
+		// A word aligned 64x64 square is skipped when all of its words are zero.
+		if (level == 6 && x >= 0 && y >= 0) {
+			uint64_t any = 0;
+			size_t y_end = std::min<size_t>(static_cast<size_t>(y) + 64, grid->height_);
+			for (size_t row = static_cast<size_t>(y); row < y_end; ++row)
+				any |= grid->cells_[row * grid->stride_ + static_cast<size_t>(x) / 64];
+			if (any == 0) return empty(life, level);
+		}
+
+		int64_t half = size / 2;
+		uint32_t nw = build_from_grid(life, grid, level - 1, x, y);
+		uint32_t ne = build_from_grid(life, grid, level - 1, x + half, y);
+		uint32_t sw = build_from_grid(life, grid, level - 1, x, y + half);
+		uint32_t se = build_from_grid(life, grid, level - 1, x + half, y + half);
+		return join(life, nw, ne, sw, se);
+	}
+
+	// Macrocell files store 8x8 leaves, bit y * 8 + x being cell (x, y).
+	constexpr uint32_t macrocell_leaf_level = 3;
+
+	uint32_t build_leaf(HashLife* life, uint64_t cells, uint32_t level, uint32_t x, uint32_t y)
+	{
+		if (level == 0) return (cells >> (y * 8 + x)) & 1 ? live_cell : dead_cell;
+		uint32_t half = uint32_t(1) << (level - 1);
+		uint32_t nw = build_leaf(life, cells, level - 1, x, y);
+		uint32_t ne = build_leaf(life, cells, level - 1, x + half, y);
+		uint32_t sw = build_leaf(life, cells, level - 1, x, y + half);
+		uint32_t se = build_leaf(life, cells, level - 1, x + half, y + half);
+		return join(life, nw, ne, sw, se);
+	}
+
+	// Reads a whole line without its line break. Returns false at the end of the file.
+	bool read_line(FILE* file, std::string& line)
+	{
+		line.clear();
+		char buffer[256];
+		while (fgets(buffer, sizeof(buffer), file) != nullptr) {
+			line += buffer;
+			if (line.back() == '\n') break;
+		}
+		while (!line.empty() && (line.back() == '\n' || line.back() == '\r'))
+			line.pop_back();
+		return !line.empty() || !feof(file);
+	}
+
+	// Writes node and every node below it that has not been written yet, children
+	// first, and returns its number in the file. Empty nodes are number 0.
+	uint32_t write_macrocell_node(const HashLife* life, uint32_t node, std::vector<uint32_t>& numbers, uint32_t& count, FILE* file)
+	{
+		const hashlife_node& n = life->nodes_[node];
+		if (n.population_ == 0) return 0;
+		if (numbers[node] != 0) return numbers[node];
+
+		if (n.level_ == macrocell_leaf_level) {
+			// Each row ends in '$'; dead cells at the end of a row and empty rows at
+			// the end of the leaf are left out.
+			char text[8 * 9 + 1];
+			size_t length = 0, used = 0;
+			for (uint64_t y = 0; y < 8; ++y) {
+				size_t row_begin = length;
+				size_t cells_end = row_begin;
+				for (uint64_t x = 0; x < 8; ++x) {
+					bool alive = cell_at(life, node, macrocell_leaf_level, x, y);
+					text[row_begin + x] = alive ? '*' : '.';
+					if (alive) cells_end = row_begin + x + 1;
+				}
+				length = cells_end;
+				text[length++] = '$';
+				if (cells_end > row_begin) used = length;
+			}
+			text[used++] = '\n';
+			fwrite(text, 1, used, file);
+		}
+		else {
+			uint32_t nw = write_macrocell_node(life, n.nw_, numbers, count, file);
+			uint32_t ne = write_macrocell_node(life, n.ne_, numbers, count, file);
+			uint32_t sw = write_macrocell_node(life, n.sw_, numbers, count, file);
+			uint32_t se = write_macrocell_node(life, n.se_, numbers, count, file);
+			fprintf(file, "%u %u %u %u %u\n", static_cast<uint32_t>(n.level_), nw, ne, sw, se);
+		}
+		numbers[node] = ++count;
+		return count;
+	}
+
+	void clear_results(HashLife* life)
+	{
+		for (hashlife_node& node : life->nodes_)
+			node.result_ = hashlife_no_node;
+	}
+
+	// Throws away every node the root can not reach. Nodes are always created after
+	// their children, so compacting in order keeps children in front of parents.
+	void collect_garbage(HashLife* life)
+	{
+		std::vector<hashlife_node>& nodes = life->nodes_;
+		std::vector<uint8_t> reachable(nodes.size(), 0);
+		std::vector<uint32_t> pending(life->empty_.begin(), life->empty_.end());
+		pending.push_back(life->root_);
+		while (!pending.empty()) {
+			uint32_t index = pending.back();
+			pending.pop_back();
+			if (reachable[index]) continue;
+			reachable[index] = 1;
+			if (index > live_cell) {
+				const hashlife_node& n = nodes[index];
+				pending.insert(pending.end(), { n.nw_, n.ne_, n.sw_, n.se_ });
+			}
+		}
+		reachable[dead_cell] = reachable[live_cell] = 1;
+
+		std::vector<uint32_t> moved_to(nodes.size(), hashlife_no_node);
+		uint32_t kept = 0;
+		for (uint32_t i = 0; i < nodes.size(); ++i) {
+			if (!reachable[i]) continue;
+			hashlife_node n = nodes[i];
+			if (i > live_cell) {
+				n.nw_ = moved_to[n.nw_];
+				n.ne_ = moved_to[n.ne_];
+				n.sw_ = moved_to[n.sw_];
+				n.se_ = moved_to[n.se_];
+			}
+			moved_to[i] = kept;
+			nodes[kept++] = n;
+		}
+		nodes.resize(kept);
+		for (hashlife_node& n : nodes) {
+			if (n.result_ != hashlife_no_node)
+				n.result_ = moved_to[n.result_];
+		}
+		for (uint32_t& e : life->empty_)
+			e = moved_to[e];
+		life->root_ = moved_to[life->root_];
+
+		size_t slot_count = 1024;
+		while (slot_count < kept * 2) slot_count *= 2;
+		rebuild_table(life, slot_count);
+		life->collect_threshold_ = std::max(min_collect_threshold, nodes.size() * 2);
+	}
+}
+
+HashLife hashlife_init() {
+	HashLife life = {
+		.nodes_ = {},
+		.table_ = std::vector<uint32_t>(1024, 0),
+		.empty_ = { dead_cell },
+		.root_ = dead_cell,
+		.rule_ = rule_conway,
+		.step_log2_ = 0,
+		.generation_ = 0,
+		.collect_threshold_ = min_collect_threshold,
+	};
+	life.nodes_.push_back({ dead_cell, dead_cell, dead_cell, dead_cell, hashlife_no_node, 0, 0, 0 });
+	life.nodes_.push_back({ dead_cell, dead_cell, dead_cell, dead_cell, hashlife_no_node, 0, 0, 1 });
+	life.root_ = empty(&life, min_root_level);
+	return life;
+}
+
+HashLife hashlife_from_grid(const Grid* grid) {
+	HashLife life = hashlife_init();
+	life.rule_ = grid->rule_;
+	uint32_t level = min_root_level;
+	while ((uint64_t(1) << (level - 1)) < std::max(grid->width_, grid->height_)) ++level;
+	int64_t half = int64_t(1) << (level - 1);
+	life.root_ = build_from_grid(&life, grid, level, -half, -half);
+	return life;
+}
+
+void hashlife_free(HashLife* life) {
+	life->nodes_ = {};
+	life->table_ = {};
+	life->empty_ = {};
+}
+
+bool hashlife_read_macrocell(HashLife* life, const char* path) {
+	FILE* file = fopen(path, "rb");
+	if (file == nullptr) return false;
+
+	// Nodes are numbered from 1 in file order; 0 is the empty node of any level.
+	HashLife loaded = hashlife_init();
+	std::vector<uint32_t> nodes = { hashlife_no_node };
+	std::string line;
+	bool ok = read_line(file, line) && line.compare(0, 4, "[M2]") == 0;
+	while (ok && read_line(file, line)) {
+		if (line.empty()) continue;
+		if (line[0] == '#') {
+			const char* value = line.c_str() + 2;
+			while (*value == ' ') ++value;
+			if (line.compare(0, 2, "#R") == 0) ok = rule_parse(value, &loaded.rule_);
+			else if (line.compare(0, 2, "#G") == 0) loaded.generation_ = strtoull(value, nullptr, 10);
+			continue;
+		}
+
+		if (line[0] >= '0' && line[0] <= '9') {
+			uint32_t level, children[4];
+			ok = sscanf(line.c_str(), "%u %u %u %u %u", &level, &children[0], &children[1], &children[2], &children[3]) == 5 &&
+				level > macrocell_leaf_level && level <= max_level;
+			for (uint32_t i = 0; ok && i < 4; ++i) {
+				if (children[i] == 0) children[i] = empty(&loaded, level - 1);
+				else if (children[i] < nodes.size() && loaded.nodes_[nodes[children[i]]].level_ == level - 1) children[i] = nodes[children[i]];
+				else ok = false;
+			}
+			if (ok) nodes.push_back(join(&loaded, children[0], children[1], children[2], children[3]));
+		}
+		else {
+			uint64_t cells = 0;
+			uint32_t x = 0, y = 0;
+			for (char c : line) {
+				if (c == '$') {
+					++y;
+					x = 0;
+				}
+				else if ((c == '*' || c == '.') && x < 8 && y < 8) {
+					if (c == '*') cells |= uint64_t(1) << (y * 8 + x);
+					++x;
+				}
+				else ok = false;
+			}
+			if (ok) nodes.push_back(build_leaf(&loaded, cells, macrocell_leaf_level, 0, 0));
+		}
+	}
+	fclose(file);
+	if (!ok) return false;
+
+	// The last node is the root, centred on (0, 0).
+	if (nodes.size() > 1) loaded.root_ = nodes.back();
+	hashlife_free(life);
+	*life = std::move(loaded);
+	return true;
+}
+
+bool hashlife_write_macrocell(const HashLife* life, const char* path) {
+	FILE* file = fopen(path, "wb");
+	if (file == nullptr) return false;
+
+	char rule_text[rule_text_size];
+	rule_format(life->rule_, rule_text);
+	fprintf(file, "[M2] (conway)\n#R %s\n", rule_text);
+	if (life->generation_ != 0)
+		fprintf(file, "#G %llu\n", static_cast<unsigned long long>(life->generation_));
+
+	// Every node is written once, however often it is shared.
+	std::vector<uint32_t> numbers(life->nodes_.size(), 0);
+	uint32_t count = 0;
+	write_macrocell_node(life, life->root_, numbers, count, file);
+
+	bool ok = ferror(file) == 0;
+	return fclose(file) == 0 && ok;
+}
+
+void hashlife_set_rule(HashLife* life, Rule rule) {
+	if (rule_equals(rule, life->rule_)) return;
+	clear_results(life);
+	life->rule_ = rule;
+}
+
+bool get_cell(const HashLife* life, int64_t x, int64_t y) {
+	if (!root_contains(life, x, y)) return false;
+	uint32_t level = life->nodes_[life->root_].level_;
+	int64_t half = int64_t(1) << (level - 1);
+	return cell_at(life, life->root_, level, static_cast<uint64_t>(x + half), static_cast<uint64_t>(y + half));
+}
+
+void write_cell(HashLife* life, int64_t x, int64_t y, bool new_value) {
+	while (!root_contains(life, x, y))
+		life->root_ = expand(life, life->root_);
+	uint32_t level = life->nodes_[life->root_].level_;
+	int64_t half = int64_t(1) << (level - 1);
+	life->root_ = set_cell(life, life->root_, level, static_cast<uint64_t>(x + half), static_cast<uint64_t>(y + half), new_value);
+}
+
+uint64_t hashlife_population(const HashLife* life) {
+	return life->nodes_[life->root_].population_;
+}
+
+void hashlife_next_generation(HashLife* life) {
+	hashlife_advance_pow2(life, 0);
+}
+
+void hashlife_next_generations(HashLife* life, uint64_t generation_count) {
+	// Smallest first: a soup gets through its busy start in small steps, which
+	// share far more nodes than large ones.
+	for (uint32_t bit = 0; bit < 64; ++bit) {
+		if ((generation_count >> bit) & 1)
+			hashlife_advance_pow2(life, bit);
+	}
+}
+
+void hashlife_advance_pow2(HashLife* life, uint32_t log2_generations) {
+	assert(log2_generations + 3 <= max_level);
+	life->step_log2_ = log2_generations;
+
+	// The result is the centre half of the root, and cells move at most one cell a
+	// generation, so everything alive has to start in the centre quarter and the
+	// step can be at most an eighth of the root.
+	for (;;) {
+		uint32_t root = life->root_;
+		if (life->nodes_[root].level_ >= log2_generations + 3 && only_centre_alive(life, root))
+			break;
+		life->root_ = expand(life, root);
+	}
+	life->root_ = successor(life, life->root_);
+	while (life->nodes_[life->root_].level_ < min_root_level)
+		life->root_ = expand(life, life->root_);
+	life->generation_ += uint64_t(1) << log2_generations;
+
+	if (life->nodes_.size() > life->collect_threshold_)
+		collect_garbage(life);
+}
@@ -0,0 +1,246 @@
+#include <pattern_file.hpp>
+#include <algorithm>
+#include <vector>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+namespace
+{
+	// Reads a file a large block at a time for the parsers, which mostly look at
+	// one character at a time.
+	struct file_reader
+	{
+		FILE* file_;
+		std::vector<char> buffer_;
+		size_t position_;
+		size_t end_;
+
+		int peek()
+		{
+			if (position_ == end_) {
+				position_ = 0;
+				end_ = fread(buffer_.data(), 1, buffer_.size(), file_);
+				if (end_ == 0) return EOF;
+			}
+			return static_cast<unsigned char>(buffer_[position_]);
+		}
+
+		int next()
+		{
+			int c = peek();
+			if (c != EOF) ++position_;
+			return c;
+		}
+
+		// Reads up to the next line break, which is skipped but not stored. Returns
+		// false at the end of the file.
+		bool read_line(std::string& line)
+		{
+			line.clear();
+			int c = next();
+			if (c == EOF) return false;
+			for (; c != EOF && c != '\n'; c = next()) {
+				if (c != '\r') line += static_cast<char>(c);
+			}
+			return true;
+		}
+	};
+
+	bool starts_with(const std::string& text, const char* prefix)
+	{
+		return text.compare(0, strlen(prefix), prefix) == 0;
+	}
+
+	// Sets the rule of info from the text of a rule line. Golly appends the
+	// bounded grid to the rule after a colon; that part is not the rule.
+	void set_rule(PatternInfo* info, const char* text)
+	{
+		while (*text == ' ' || *text == '\t') ++text;
+		info->rule_text_ = text;
+		while (!info->rule_text_.empty() && strchr(" \t", info->rule_text_.back()) != nullptr)
+			info->rule_text_.pop_back();
+		std::string rule = info->rule_text_.substr(0, info->rule_text_.find(':'));
+		info->rule_valid_ = rule_parse(rule.c_str(), &info->rule_);
+	}
+
+	// Parses the "x = 3, y = 3, rule = B3/S23" line of an RLE file.
+	bool parse_rle_header(const std::string& line, PatternInfo* info)
+	{
+		size_t rule_at = line.find("rule");
+		if (rule_at != std::string::npos) {
+			size_t value_at = line.find('=', rule_at);
+			if (value_at == std::string::npos) return false;
+			set_rule(info, line.c_str() + value_at + 1);
+		}
+		return line.find('x') != std::string::npos && line.find('y') != std::string::npos;
+	}
+
+	template <typename run_type>
+	bool read_rle(file_reader& reader, std::string& line, int64_t x0, int64_t y0, run_type& live_run)
+	{
+		int64_t x = x0;
+		int64_t y = y0;
+		uint64_t count = 0;
+		for (;;) {
+			int c = reader.next();
+			if (c >= '0' && c <= '9') {
+				count = count * 10 + static_cast<uint64_t>(c - '0');
+				if (count > (uint64_t(1) << 40)) return false;
+				continue;
+			}
+			if (c == ' ' || c == '\t' || c == '\r' || c == '\n') continue;
+
+			const uint64_t run = count == 0 ? 1 : count;
+			count = 0;
+			if (c == 'b' || c == '.') {
+				x += static_cast<int64_t>(run);
+			}
+			else if (c == '$') {
+				y += static_cast<int64_t>(run);
+				x = x0;
+			}
+			else if (c == '!' || c == EOF) {
+				return true;
+			}
+			else if ((c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'X')) {
+				// Two state files only use 'o'; any other state counts as alive.
+				// Multi-state files write states past 24 as a prefix from 'p' to
+				// 'y' and a letter from 'A' to 'X', which are one cell together.
+				if (c >= 'p' && c <= 'y' && reader.peek() >= 'A' && reader.peek() <= 'X') reader.next();
+				live_run(x, y, run);
+				x += static_cast<int64_t>(run);
+			}
+			else if (c == '#') {
+				reader.read_line(line);
+			}
+			else {
+				return false;
+			}
+		}
+	}
+
+	// Starts at the line already in line.
+	template <typename run_type>
+	bool read_plaintext(file_reader& reader, std::string& line, run_type& live_run)
+	{
+		int64_t y = 0;
+		do {
+			if (starts_with(line, "!")) continue;
+			int64_t run_begin = 0;
+			bool in_run = false;
+			for (size_t x = 0; x <= line.size(); ++x) {
+				char c = x < line.size() ? line[x] : '.';
+				bool alive = c == 'O' || c == '*';
+				if (!alive && c != '.' && c != ' ') return false;
+				if (alive && !in_run) run_begin = static_cast<int64_t>(x);
+				if (!alive && in_run) live_run(run_begin, y, static_cast<uint64_t>(static_cast<int64_t>(x) - run_begin));
+				in_run = alive;
+			}
+			++y;
+		} while (reader.read_line(line));
+		return true;
+	}
+
+	template <typename run_type>
+	bool read_life_106(file_reader& reader, std::string& line, run_type& live_run)
+	{
+		while (reader.read_line(line)) {
+			if (starts_with(line, "#")) continue;
+			const char* text = line.c_str();
+			char* end;
+			long long x = strtoll(text, &end, 10);
+			if (end == text) {
+				if (strspn(text, " \t") == line.size()) continue;
+				return false;
+			}
+			text = end;
+			long long y = strtoll(text, &end, 10);
+			if (end == text) return false;
+			live_run(x, y, 1);
+		}
+		return true;
+	}
+}
+
+bool pattern_read(const char* path, const pattern_run_fn& live_run, PatternInfo* info) {
+	*info = {
+		.format_ = pattern_format::rle,
+		.min_x_ = INT64_MAX,
+		.min_y_ = INT64_MAX,
+		.max_x_ = INT64_MIN,
+		.max_y_ = INT64_MIN,
+		.population_ = 0,
+		.rule_text_ = {},
+		.rule_valid_ = false,
+		.rule_ = rule_conway,
+	};
+
+	FILE* file = fopen(path, "rb");
+	if (file == nullptr) return false;
+	file_reader reader = { file, std::vector<char>(size_t(1) << 16), 0, 0 };
+
+	auto counted_run = [&live_run, info](int64_t x, int64_t y, uint64_t length) {
+		info->min_x_ = std::min(info->min_x_, x);
+		info->min_y_ = std::min(info->min_y_, y);
+		info->max_x_ = std::max(info->max_x_, x + static_cast<int64_t>(length) - 1);
+		info->max_y_ = std::max(info->max_y_, y);
+		info->population_ += length;
+		live_run(x, y, length);
+	};
+
+	// The format shows in the first lines: comments up to an RLE header, a Life
+	// 1.06 header, or plaintext comments and rows.
+	bool ok = false;
+	std::string line;
+	int64_t rle_x = 0, rle_y = 0;
+	bool have_line;
+	while ((have_line = reader.read_line(line)) && line.find_first_not_of(" \t") == std::string::npos) {}
+	for (; have_line; have_line = reader.read_line(line)) {
+		if (starts_with(line, "#Life 1.06")) {
+			info->format_ = pattern_format::life_106;
+			ok = read_life_106(reader, line, counted_run);
+			break;
+		}
+		if (starts_with(line, "#r")) {
+			set_rule(info, line.c_str() + 2);
+		}
+		else if (starts_with(line, "#CXRLE")) {
+			// Golly stores where the pattern sits as "Pos=x,y".
+			size_t position_at = line.find("Pos=");
+			long long position_x, position_y;
+			if (position_at != std::string::npos) {
+				if (sscanf(line.c_str() + position_at + 4, "%lld,%lld", &position_x, &position_y) != 2) break;
+				rle_x = position_x;
+				rle_y = position_y;
+			}
+		}
+		else if (starts_with(line, "#")) {
+			continue;
+		}
+		else if (starts_with(line, "!") || line.find_first_not_of(".O* ") == std::string::npos) {
+			info->format_ = pattern_format::plaintext;
+			ok = read_plaintext(reader, line, counted_run);
+			break;
+		}
+		else {
+			info->format_ = pattern_format::rle;
+			ok = parse_rle_header(line, info) && read_rle(reader, line, rle_x, rle_y, counted_run);
+			break;
+		}
+	}
+	fclose(file);
+	return ok;
+}
+
+bool grid_load_pattern(Grid* grid, const char* path, int64_t x, int64_t y, PatternInfo* info) {
+	const int64_t width = static_cast<int64_t>(grid->width_);
+	const int64_t height = static_cast<int64_t>(grid->height_);
+	return pattern_read(path, [grid, x, y, width, height](int64_t run_x, int64_t run_y, uint64_t length) {
+		int64_t row = y + run_y;
+		int64_t begin = std::max<int64_t>(x + run_x, 0);
+		int64_t end = std::min<int64_t>(x + run_x + static_cast<int64_t>(length), width);
+		if (row < 0 || row >= height || begin >= end) return;
+		grid_fill_run(grid, static_cast<size_t>(begin), static_cast<size_t>(row), static_cast<size_t>(end - begin), true);
+	}, info);
+}
@@ -0,0 +1,48 @@
+#include <rule.hpp>
+
+namespace
+{
+	// Reads neighbour counts into a mask, up to the first character that is not one.
+	const char* parse_counts(const char* text, uint32_t* mask)
+	{
+		*mask = 0;
+		for (; *text >= '0' && *text <= '8'; ++text)
+			*mask |= uint32_t(1) << (*text - '0');
+		return text;
+	}
+
+	char* format_counts(uint32_t mask, char* text)
+	{
+		for (uint32_t count = 0; count <= 8; ++count) {
+			if ((mask >> count) & 1) *text++ = static_cast<char>('0' + count);
+		}
+		return text;
+	}
+}
+
+bool rule_parse(const char* text, Rule* rule) {
+	Rule parsed;
+	if (*text == 'B' || *text == 'b') {
+		text = parse_counts(text + 1, &parsed.birth_);
+		if (*text == '/') ++text;
+		if (*text != 'S' && *text != 's') return false;
+		text = parse_counts(text + 1, &parsed.survival_);
+	}
+	else {
+		text = parse_counts(text, &parsed.survival_);
+		if (*text != '/') return false;
+		text = parse_counts(text + 1, &parsed.birth_);
+	}
+	if (*text != '\0' || (parsed.birth_ & 1) != 0) return false;
+	*rule = parsed;
+	return true;
+}
+
+void rule_format(Rule rule, char* text) {
+	*text++ = 'B';
+	text = format_counts(rule.birth_, text);
+	*text++ = '/';
+	*text++ = 'S';
+	text = format_counts(rule.survival_, text);
+	*text = '\0';
+}
@@ -0,0 +1,180 @@
+#include <simulation.hpp>
+#include <algorithm>
+#include <bit>
+
+namespace
+{
+	// Faster than any display, so a frame never shows an older generation than it could.
+	constexpr std::chrono::microseconds publish_interval(4000);
+	// A view of many cells takes a while to capture: it gets at most 1 / publish_cost_share of the thread.
+	constexpr int publish_cost_share = 4;
+	// A step is taken in chunks of generations of about this long, so an edit or new settings wait no longer.
+	constexpr std::chrono::microseconds chunk_duration(2000);
+}
+
+simulation::simulation(Grid* grid, double steps_per_second, step_speed speed, const board_view& view, std::function<void(Grid*)> on_step) :
+	grid_(grid),
+	step_interval_(steps_per_second > 0 ?
+		std::chrono::duration_cast<clock::duration>(std::chrono::duration<double>(1.0 / steps_per_second)) :
+		clock::duration::zero()),
+	on_step_(std::move(on_step)),
+	speed_(speed),
+	view_(view),
+	next_speed_(speed),
+	next_view_(view)
+{
+	publish();
+	thread_ = std::thread(&simulation::work, this);
+}
+
+simulation::~simulation()
+{
+	change_settings([this] { stopping_ = true; });
+	thread_.join();
+}
+
+void simulation::set_running(bool running)
+{
+	change_settings([this, running] { running_ = running; });
+}
+
+void simulation::set_speed(step_speed speed)
+{
+	change_settings([this, speed] {
+		next_speed_ = speed;
+		speed_changed_ = true;
+	});
+}
+
+void simulation::set_view(const board_view& view)
+{
+	change_settings([this, &view] {
+		next_view_ = view;
+		view_changed_ = true;
+	});
+}
+
+void simulation::take_settings()
+{
+	std::unique_lock<std::mutex> control(control_mutex_);
+	settings_changed_ = false;
+	// A new view shows right away, and the last generation before a pause has to be seen as well.
+	const bool publish_now = view_changed_ || (!running_ && published_generation_ != grid_->generation_);
+	if (speed_changed_) {
+		speed_ = next_speed_;
+		last_generations_ = 1;
+		// What is left of a step at the old speed is dropped; hyper steps line up again by themselves.
+		step_left_ = 0;
+	}
+	if (view_changed_) view_ = next_view_;
+	speed_changed_ = view_changed_ = false;
+	control.unlock();
+	if (publish_now) publish();
+}
+
+uint64_t simulation::step_generations() const
+{
+	uint64_t generations = speed_.generations_;
+	if (speed_.budget_ != std::chrono::microseconds::zero()) {
+		// Growing at most twofold a step, so a step measured on a quiet board
+		// can not send a busy one off for minutes.
+		const double fit = seconds_per_generation_ > 0 ?
+			std::chrono::duration<double>(speed_.budget_).count() / seconds_per_generation_ : 2.0 * last_generations_;
+		generations = static_cast<uint64_t>(std::clamp(fit, 1.0, 2.0 * last_generations_));
+	}
+	generations = std::max<uint64_t>(generations, 1);
+	if (speed_.hyper_) {
+		generations = std::bit_floor(generations);
+		// Up to the next multiple first: the lowest set bit of the generation.
+		const uint64_t generation = grid_->generation_;
+		if (generation != 0) generations = std::min(generations, generation & (0 - generation));
+	}
+	return generations;
+}
+
+std::unique_lock<std::mutex> simulation::wait_for_grid()
+{
+	++waiting_;
+	return std::unique_lock<std::mutex>(mutex_);
+}
+
+void simulation::done_with_grid(std::unique_lock<std::mutex>& lock)
+{
+	lock.unlock();
+	{
+		// Under control_mutex_, or the simulation thread could miss the wake-up.
+		std::lock_guard<std::mutex> control(control_mutex_);
+		--waiting_;
+	}
+	woken_.notify_all();
+}
+
+void simulation::publish()
+{
+	const clock::time_point start = clock::now();
+	board_frame_capture(&frames_.back(), grid_, view_);
+	frames_.publish();
+	last_publish_ = clock::now();
+	publish_cost_ = last_publish_ - start;
+	published_generation_ = grid_->generation_;
+}
+
+void simulation::work()
+{
+	clock::time_point next_step = clock::now();
+	std::unique_lock<std::mutex> control(control_mutex_);
+	for (;;)
+	{
+		// Whoever waits for the grid goes first; they wake us when done.
+		woken_.wait(control, [this] { return stopping_ || settings_changed_ || (waiting_ == 0 && running_); });
+		if (stopping_) return;
+
+		if (settings_changed_) {
+			control.unlock();
+			{
+				std::lock_guard<std::mutex> lock(mutex_);
+				take_settings();
+			}
+			control.lock();
+			if (!running_) next_step = clock::now();
+			continue;
+		}
+
+		// Only a new step waits for its time; one left off carries on right away.
+		if (step_interval_ != clock::duration::zero() && step_left_ == 0) {
+			// Woken early for new settings, an edit or a pause: back to waiting.
+			if (woken_.wait_until(control, next_step, [this] { return waiting_ != 0 || stopping_ || settings_changed_ || !running_; })) {
+				if (!running_) next_step = clock::now();
+				continue;
+			}
+			// After falling behind, e.g. on a slow generation, carry on from now instead of catching up.
+			next_step = std::max(next_step + step_interval_, clock::now() - step_interval_);
+		}
+
+		control.unlock();
+		{
+			std::lock_guard<std::mutex> lock(mutex_);
+			// A step left off for an edit or new settings carries on where it was.
+			if (step_left_ == 0) step_size_ = step_left_ = step_generations();
+			do {
+				const double fit = seconds_per_generation_ > 0 ? std::chrono::duration<double>(chunk_duration).count() / seconds_per_generation_ : 1.0;
+				// Growing at most twofold, like the steps of a budget.
+				const uint64_t chunk = static_cast<uint64_t>(std::clamp(fit, 1.0, std::min(2.0 * last_chunk_, static_cast<double>(step_left_))));
+				const clock::time_point chunk_start = clock::now();
+				grid_next_generations(grid_, chunk);
+				seconds_per_generation_ = std::chrono::duration<double>(clock::now() - chunk_start).count() / chunk;
+				last_chunk_ = chunk;
+				step_left_ -= chunk;
+			} while (step_left_ != 0 && waiting_ == 0 && !settings_changed_);
+
+			// Only whole steps are published, or hyper steps would show other phases.
+			if (step_left_ == 0) {
+				last_generations_ = step_size_;
+				if (on_step_) on_step_(grid_);
+				const clock::duration interval = std::max<clock::duration>(publish_interval, publish_cost_ * publish_cost_share);
+				if (clock::now() - last_publish_ >= interval || step_interval_ >= interval) publish();
+			}
+		}
+		control.lock();
+	}
+}
@@ -0,0 +1,78 @@
+#include <thread_pool.hpp>
+#include <algorithm>
+#include <assert.h>
+
+namespace
+{
+	size_t resolve_thread_count(size_t thread_count)
+	{
+		if (thread_count != 0) return thread_count;
+		return std::max<size_t>(std::thread::hardware_concurrency(), 1);
+	}
+}
+
+thread_pool::thread_pool(size_t thread_count) :
+	barrier_(static_cast<ptrdiff_t>(resolve_thread_count(thread_count)), round_completion{ this })
+{
+	thread_count = resolve_thread_count(thread_count);
+	workers_.reserve(thread_count - 1);
+	for (size_t i = 1; i < thread_count; ++i)
+		workers_.emplace_back(&thread_pool::work, this, i);
+}
+
+thread_pool::~thread_pool()
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		stopping_ = true;
+	}
+	job_posted_.notify_all();
+	for (std::thread& worker : workers_)
+		worker.join();
+}
+
+void thread_pool::run(size_t round_count, const std::function<void(size_t)>& task, const std::function<void()>& round_end)
+{
+	if (round_count == 0) return;
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		round_count_ = round_count;
+		task_ = &task;
+		round_end_ = &round_end;
+		++job_id_;
+	}
+	job_posted_.notify_all();
+
+	// Every worker passes the barrier of the last round before this returns, and
+	// none of them touches the job again after that.
+	run_rounds(0, round_count, task);
+}
+
+void thread_pool::work(size_t thread_index)
+{
+	uint64_t last_job_id = 0;
+	for (;;)
+	{
+		size_t round_count;
+		const std::function<void(size_t)>* task;
+		{
+			std::unique_lock<std::mutex> lock(mutex_);
+			job_posted_.wait(lock, [&] { return stopping_ || job_id_ != last_job_id; });
+			if (stopping_) return;
+			last_job_id = job_id_;
+			round_count = round_count_;
+			task = task_;
+		}
+		run_rounds(thread_index, round_count, *task);
+	}
+}
+
+void thread_pool::run_rounds(size_t thread_index, size_t round_count, const std::function<void(size_t)>& task)
+{
+	assert(thread_index < thread_count());
+	for (size_t round = 0; round < round_count; ++round)
+	{
+		task(thread_index);
+		barrier_.arrive_and_wait();
+	}
+}
@@ -31,8 +31,8 @@ GLuint init_blit_shader();
 void   free_blit_shader(GLuint shader_program_id);
 void   init_blit_vertices(GLuint& out_vao, GLuint& out_vbo);
 void   free_blit_vertices(GLuint& ref_vao, GLuint& ref_vbo);
-GLuint init_blit_texture();
-void   updt_blit_texture(GLuint tex_id, glm::u32* pixel_data, GLsizei width, GLsizei height, GLint stride);
+GLuint init_blit_texture(GLsizei width, GLsizei height);
+void   updt_blit_texture(GLuint tex_id, tmpl8::surface& screen);
 void   free_blit_texture(GLuint& tex_id);
 void   draw_blit(GLuint shader_id, GLuint vao, GLuint tex_id);
 
@@ -84,7 +84,7 @@ namespace tmpl8
 			GLuint vao, vbo;
 			init_blit_vertices(vao, vbo);
 
-			GLuint blit_texure_id = init_blit_texture();
+			GLuint blit_texure_id = init_blit_texture(config::screen_width, config::screen_height);
 
 			glfwSwapInterval(config::use_vsync ? 1 : 0);
 
@@ -116,7 +116,7 @@ namespace tmpl8
 
 					TMPL8_RENDERER_CHECK_ERRORS();
 
-					updt_blit_texture(blit_texure_id, screen.buffer(), config::screen_width, config::screen_height, 0);
+					updt_blit_texture(blit_texure_id, screen);
 					draw_blit(shader_program_id, vao, blit_texure_id);
 
 					TMPL8_RENDERER_CHECK_ERRORS();
@@ -273,7 +273,7 @@ void free_blit_vertices(GLuint& vao, GLuint& vbo)
 	glDeleteVertexArrays(1, &vao);
 }
 
-GLuint init_blit_texture()
+GLuint init_blit_texture(GLsizei width, GLsizei height)
 {
 	GLuint texId;
 	glGenTextures(1, &texId);
@@ -283,15 +283,28 @@ GLuint init_blit_texture()
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, config::scale_interpolate ? GL_LINEAR : GL_NEAREST);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, config::scale_interpolate ? GL_LINEAR : GL_NEAREST);
+	// Allocated once, only ever updated in place. (glTexStorage2D needs GL 4.2.)
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, 0);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, width, height, 0, GL_BGRA, GL_UNSIGNED_BYTE, nullptr);
 
 	glBindTexture(GL_TEXTURE_2D, 0);
 	return texId;
 }
 
-void updt_blit_texture(GLuint tex_id, glm::u32* pixel_data, GLsizei width, GLsizei height, GLint stride)
+void updt_blit_texture(GLuint tex_id, tmpl8::surface& screen)
 {
+	// Only what changed since the last upload, and nothing for an unchanged frame.
+	const tmpl8::rect dirty = screen.take_dirty();
+	if (dirty.empty()) return;
+
 	glBindTexture(GL_TEXTURE_2D, tex_id);
-	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, width, height, stride, GL_BGRA, GL_UNSIGNED_BYTE, pixel_data);
+	glPixelStorei(GL_UNPACK_ROW_LENGTH, screen.pitch());
+	glPixelStorei(GL_UNPACK_SKIP_PIXELS, dirty.x1);
+	glPixelStorei(GL_UNPACK_SKIP_ROWS, dirty.y1);
+	glTexSubImage2D(GL_TEXTURE_2D, 0, dirty.x1, dirty.y1, dirty.x2 - dirty.x1, dirty.y2 - dirty.y1, GL_BGRA, GL_UNSIGNED_BYTE, screen.buffer());
+	glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+	glPixelStorei(GL_UNPACK_SKIP_PIXELS, 0);
+	glPixelStorei(GL_UNPACK_SKIP_ROWS, 0);
 	glBindTexture(GL_TEXTURE_2D, 0);
 }
 
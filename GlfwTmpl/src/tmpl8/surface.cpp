@@ -2,6 +2,7 @@
 #include <lodepng/lodepng.hpp>
 #include <vector>
 #include <algorithm>
+#include <cstring>
 
 namespace
 {
@@ -83,6 +84,7 @@ namespace tmpl8
 	{
 		buffer_ = std::make_unique<pixel[]>(height_ * pitch_);
 		std::memcpy(buffer_.get(), other.buffer_.get(), sizeof(pixel) * height_ * pitch_);
+		mark_dirty();
 	}
 
 	surface& surface::operator=(const surface& other)
@@ -101,6 +103,7 @@ namespace tmpl8
 		}
 
 		std::memcpy(buffer_.get(), other.buffer_.get(), sizeof(pixel) * pitch_ * height_);
+		mark_dirty();
 
 		return *this;
 	}
@@ -114,6 +117,8 @@ namespace tmpl8
 		other.width_  = 0;
 		other.height_ = 0;
 		other.pitch_  = 0;
+		other.dirty_  = rect();
+		mark_dirty();
 	}
 
 	surface& surface::operator=(surface&& other) noexcept
@@ -126,6 +131,8 @@ namespace tmpl8
 		other.width_  = 0;
 		other.height_ = 0;
 		other.pitch_  = 0;
+		other.dirty_  = rect();
+		mark_dirty();
 
 		return *this;
 	}
@@ -151,6 +158,7 @@ namespace tmpl8
 				buffer_[(h - y - 1) * w + x] = a << 24 | r << 16 | g << 8 | b;
 			}
 		}
+		mark_dirty();
 	}
 
 	surface::surface(int32_t width, int32_t height) : surface(width, height, width) { }
@@ -161,6 +169,7 @@ namespace tmpl8
 	{
 		assert(width_ > 0 && height_ > 0 && pitch_ >= width_);
 		buffer_ = std::make_unique<pixel[]>(pitch_ * height_);
+		mark_dirty();
 	}
 
 	surface::surface(int32_t width, int32_t height, std::unique_ptr<pixel[]> buffer, int32_t pitch) :
@@ -171,6 +180,7 @@ namespace tmpl8
 	{
 		assert(width_ > 0 && height_ > 0 && pitch_ >= width_);
 		assert(buffer_ != nullptr);
+		mark_dirty();
 	}
 
 	surface::operator bool() const noexcept
@@ -178,6 +188,33 @@ namespace tmpl8
 		return buffer_ != nullptr;
 	}
 
+	rect surface::take_dirty()
+	{
+		rect dirty = dirty_;
+		dirty_ = rect();
+		return dirty;
+	}
+
+	void surface::mark_dirty(const rect& area)
+	{
+		rect clipped = { std::max(area.x1, 0), std::max(area.y1, 0), std::min(area.x2, width_), std::min(area.y2, height_) };
+		if (clipped.empty()) return;
+		if (dirty_.empty())
+		{
+			dirty_ = clipped;
+			return;
+		}
+		dirty_.x1 = std::min(dirty_.x1, clipped.x1);
+		dirty_.y1 = std::min(dirty_.y1, clipped.y1);
+		dirty_.x2 = std::max(dirty_.x2, clipped.x2);
+		dirty_.y2 = std::max(dirty_.y2, clipped.y2);
+	}
+
+	void surface::mark_dirty()
+	{
+		dirty_ = { 0, 0, width_, height_ };
+	}
+
 	pixel surface::operator()(int32_t x, int32_t y) const
 	{
 		return buffer_[x + y * pitch_];
@@ -197,6 +234,7 @@ namespace tmpl8
 	void surface::clear(pixel clear_color)
 	{
 		assert(*this);
+		mark_dirty();
 		
 		pixel clear_hue = clear_color & 0xff;
 		if (clear_hue == ((clear_color >>  8) & 0xff) &&
@@ -220,10 +258,13 @@ namespace tmpl8
 		assert(*this);
 		assert(x >= 0 && y >= 0 && x < width_ && y < height_);
 		buffer_[x + y * pitch_] = color;
+		mark_dirty({ x, y, x + 1, y + 1 });
 	}
 
-	void print_helper(const char* str_buffer, size_t str_length, int32_t x, int32_t y, pixel color, pixel* buffer, int32_t pitch)
+	// Returns the area printed to.
+	rect print_helper(const char* str_buffer, size_t str_length, int32_t x, int32_t y, pixel color, pixel* buffer, int32_t pitch)
 	{
+		rect area = { x, y, x, y };
 		for (size_t i = 0; i < str_length; i++)
 		{
 			size_t c = str_buffer[i];
@@ -234,6 +275,7 @@ namespace tmpl8
 			auto bottom = static_cast<int32_t>(data & 0xf); data >>= 4;
 			auto width  = static_cast<int32_t>(data & 0xf); data >>= 4;
 			auto height = static_cast<int32_t>(data & 0xf); data >>= 4;
+			area.y2 = std::max(area.y2, y + bottom + height);
 
 			pixel* dst = buffer + x + (y + bottom) * pitch;
 			size_t adv = pitch - width;
@@ -247,14 +289,16 @@ namespace tmpl8
 			}
 
 			x += width + 1;
+			area.x2 = x;
 		}
+		return area;
 	}
 
 	void surface::print(const std::string& string, int32_t x, int32_t y, pixel color)
 	{
 		assert(*this);
 
-		print_helper(string.data(), string.length(), x, y, color, buffer_.get(), pitch_);
+		mark_dirty(print_helper(string.data(), string.length(), x, y, color, buffer_.get(), pitch_));
 	}
 
 	void surface::print(const char* string, int32_t x, int32_t y, pixel color)
@@ -262,7 +306,7 @@ namespace tmpl8
 		assert(*this);
 
 		size_t len = strlen(string);
-		print_helper(string, len, x, y, color, buffer_.get(), pitch_);
+		mark_dirty(print_helper(string, len, x, y, color, buffer_.get(), pitch_));
 	}
 
 	void surface::draw(const surface& image, int32_t x, int32_t y)
@@ -285,6 +329,9 @@ namespace tmpl8
 			x2 < 0 || y2 < 0 || x2 >= width_ || y2 >= height_)
 			return;
 
+		mark_dirty({ static_cast<int32_t>(std::min(x1, x2)), static_cast<int32_t>(std::min(y1, y2)),
+			static_cast<int32_t>(std::max(x1, x2)) + 1, static_cast<int32_t>(std::max(y1, y2)) + 1 });
+
 		float delta_x = x2 - x1;
 		float delta_y = y2 - y1;
 		float line_length = std::max(std::abs(delta_x), std::abs(delta_y));
@@ -305,6 +352,7 @@ namespace tmpl8
 
 		if (x1 > x2) std::swap(x1, x2);
 		if (y1 > y2) std::swap(y1, y2);
+		mark_dirty({ x1, y1, x2 + 1, y2 + 1 });
 
 		if (x2 >= 0 && x1 < width_)
 		{
@@ -352,6 +400,7 @@ namespace tmpl8
 		y1 = std::max(y1, 0);
 		x2 = std::min(x2, width_  - 1);
 		y2 = std::min(y2, height_ - 1);
+		mark_dirty({ x1, y1, x2 + 1, y2 + 1 });
 
 		pixel* dst = buffer_.get() + y1 * pitch_ + x1;
 		size_t adv = pitch_ - (x2 + 1 - x1);
@@ -0,0 +1,136 @@
+// The bit-sliced batch against a grid per universe, for every kernel this
+// machine runs: the cells, and what each universe settled into.
+#include "test.hpp"
+#include <batch.hpp>
+#include <grid.hpp>
+#include <grid_history.hpp>
+#include <grid_kernel.hpp>
+#include <random>
+#include <vector>
+
+namespace
+{
+	constexpr size_t side = 20;
+	// Not a multiple of 64: the last word of a cell is partly unused.
+	constexpr size_t universe_count = 150;
+
+	// Soups of different densities, so that some die, some settle and some keep going a while.
+	void fill(Batch* batch, Grid* grids, std::mt19937_64& random)
+	{
+		for (size_t universe = 0; universe < universe_count; ++universe) {
+			const uint64_t density = 10 + universe % 50;
+			for (size_t y = 0; y < side; ++y) {
+				for (size_t x = 0; x < side; ++x) {
+					const bool alive = random() % 100 < density;
+					write_cell(batch, universe, x, y, alive);
+					write_cell(&grids[universe], x, y, alive);
+				}
+			}
+		}
+	}
+
+	bool same_cells(const Batch* batch, size_t universe, const Grid* grid)
+	{
+		uint64_t population = 0;
+		for (size_t y = 0; y < side; ++y) {
+			for (size_t x = 0; x < side; ++x) {
+				if (get_cell(batch, universe, x, y) != get_cell(grid, x, y)) return false;
+				population += get_cell(grid, x, y);
+			}
+		}
+		return population == batch_population(batch, universe);
+	}
+}
+
+TEST(batch_matches_grids)
+{
+	const kernel_isa isas[] = { kernel_isa::scalar, kernel_isa::sse2, kernel_isa::avx2, kernel_isa::avx512 };
+	const Rule rules[] = { rule_conway, rule_highlife };
+	const kernel_isa previous = grid_active_kernel();
+	std::mt19937_64 random(12);
+	for (kernel_isa isa : isas) {
+		if (isa > kernel_isa_detect()) continue;
+		grid_use_kernel(isa);
+		for (Rule rule : rules) {
+			Batch batch = batch_init(side, side, universe_count);
+			CHECK(batch.universe_count_ >= universe_count && batch.universe_count_ % 64 == 0);
+			batch_set_rule(&batch, rule);
+			std::vector<Grid> grids;
+			for (size_t universe = 0; universe < universe_count; ++universe) {
+				grids.push_back(grid_init(side, side));
+				grid_set_boundary(&grids.back(), grid_boundary::torus);
+				grid_set_rule(&grids.back(), rule);
+			}
+			fill(&batch, grids.data(), random);
+
+			bool same = true;
+			for (int generation = 0; generation < 40; ++generation) {
+				batch_next_generation(&batch);
+				for (size_t universe = 0; universe < universe_count; ++universe) {
+					grid_next_generation(&grids[universe]);
+					same &= same_cells(&batch, universe, &grids[universe]);
+				}
+			}
+			CHECK(same);
+
+			// Into a grid as it is now.
+			Grid copy = grid_init(side + 5, side + 3);
+			batch_copy_universe(&batch, 7, &copy);
+			bool copied = true;
+			for (size_t y = 0; y < side; ++y)
+				for (size_t x = 0; x < side; ++x)
+					copied &= get_cell(&copy, x, y) == get_cell(&grids[7], x, y);
+			CHECK(copied);
+			grid_free(&copy);
+
+			for (Grid& grid : grids)
+				grid_free(&grid);
+			batch_free(&batch);
+		}
+	}
+	grid_use_kernel(previous);
+}
+
+TEST(batch_settles_like_grids)
+{
+	Batch batch = batch_init(side, side, universe_count);
+	std::vector<Grid> grids;
+	for (size_t universe = 0; universe < universe_count; ++universe) {
+		grids.push_back(grid_init(side, side));
+		grid_set_boundary(&grids.back(), grid_boundary::torus);
+	}
+	std::mt19937_64 random(21);
+	for (int round = 0; round < 2; ++round) {
+		// The second round after batch_clear, on the same batch.
+		if (round == 1) {
+			batch_clear(&batch);
+			for (Grid& grid : grids) {
+				grid_free(&grid);
+				grid = grid_init(side, side);
+				grid_set_boundary(&grid, grid_boundary::torus);
+			}
+		}
+		fill(&batch, grids.data(), random);
+		const bool all_settled = batch_run_until_settled(&batch, 5000);
+
+		size_t settled = 0, oscillating = 0;
+		bool same = true;
+		for (size_t universe = 0; universe < universe_count; ++universe) {
+			grid_history history(8192);
+			const GridPeriod period = grid_run_until_settled(&grids[universe], &history, 5000);
+			const BatchResult& result = batch.results_[universe];
+			same &= result.settling_ == period.settling_ && result.period_ == period.period_;
+			// Brent's method finds it later than a full history, never earlier.
+			same &= period.settling_ == grid_settling::running || result.generation_ >= grids[universe].generation_;
+			settled += period.settling_ != grid_settling::running;
+			oscillating += period.settling_ == grid_settling::oscillating;
+		}
+		CHECK(same);
+		CHECK(all_settled == (settled == universe_count));
+		// Both kinds of result came up.
+		CHECK(settled > universe_count / 2 && oscillating > 0);
+	}
+	for (Grid& grid : grids)
+		grid_free(&grid);
+	batch_free(&batch);
+}
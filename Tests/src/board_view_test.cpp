@@ -0,0 +1,102 @@
+// What a zoomed out view shows, from the tile stats and from the cells.
+#include "test.hpp"
+#include <board_view.hpp>
+#include <grid.hpp>
+
+namespace
+{
+	// Captures view of both grids; only the first one tracks stats, so the two
+	// frames come from the tile stats and from the cells.
+	bool same_density(const Grid* tracked, const Grid* untracked, const board_view& view)
+	{
+		board_frame from_tiles, from_cells;
+		board_frame_capture(&from_tiles, tracked, view);
+		board_frame_capture(&from_cells, untracked, view);
+		return from_tiles.density_ == from_cells.density_;
+	}
+
+	bool any_density(const Grid* grid, const board_view& view)
+	{
+		board_frame frame;
+		board_frame_capture(&frame, grid, view);
+		for (uint8_t density : frame.density_)
+			if (density != 0) return true;
+		return false;
+	}
+}
+
+TEST(board_view_density_from_tile_stats)
+{
+	Grid tracked = grid_init(1024, 1024), untracked = grid_init(1024, 1024);
+	grid_randomize(&tracked, 0.3, 11);
+	grid_randomize(&untracked, 0.3, 11);
+	grid_track_stats(&tracked, true);
+	// Blocks of 128 cells, two tiles across and down.
+	const board_view view = board_view_fit(1024, 1024, 8, 8);
+	CHECK(view.zoom_ == -7);
+
+	// Before the first generation, and after one.
+	CHECK(any_density(&tracked, view));
+	CHECK(same_density(&tracked, &untracked, view));
+	grid_next_generation(&tracked);
+	grid_next_generation(&untracked);
+	CHECK(same_density(&tracked, &untracked, view));
+
+	// Written to between generations: a block cleared, a few cells in an empty one.
+	Grid* grids[] = { &tracked, &untracked };
+	for (Grid* grid : grids) {
+		for (size_t y = 0; y < 256; ++y)
+			grid_fill_run(grid, 0, y, 256, false);
+		write_cell(grid, 10, 10, true);
+		write_cell(grid, 200, 130, true);
+		for (size_t y = 512; y < 640; ++y)
+			grid_fill_run(grid, 384, y, 100, true);
+	}
+	CHECK(same_density(&tracked, &untracked, view));
+	const GridStats stats = grid_stats(&tracked);
+	CHECK(stats.population_ == grid_stats(&untracked).population_);
+	grid_next_generation(&tracked);
+	grid_next_generation(&untracked);
+	CHECK(same_density(&tracked, &untracked, view));
+
+	grid_free(&tracked);
+	grid_free(&untracked);
+}
+
+TEST(board_view_density_from_tile_sums)
+{
+	// Off a power of two of tiles both ways, so the blocks on the far edges hang off the board.
+	constexpr size_t width = 64 * 13 + 20, height = 64 * 11 + 5;
+	for (size_t thread_count : { 1, 3 }) {
+		Grid tracked = grid_init(width, height), untracked = grid_init(width, height);
+		grid_set_thread_count(&tracked, thread_count);
+		grid_randomize(&tracked, 0.2, 5);
+		grid_randomize(&untracked, 0.2, 5);
+		grid_track_stats(&tracked, true);
+
+		bool same = true;
+		for (int generation = 0; generation < 30 && same; ++generation) {
+			// A tile each, up to blocks larger than the board, panned by blocks so some hang off the top left.
+			for (int32_t zoom = -6; zoom >= -11; --zoom) {
+				board_view view = board_view_fit(width, height, 40, 30);
+				view.zoom_ = zoom;
+				view.x_ = 0;
+				view.y_ = 0;
+				same &= same_density(&tracked, &untracked, view);
+				same &= same_density(&tracked, &untracked, board_view_pan(view, -3, -2));
+			}
+			grid_next_generation(&tracked);
+			grid_next_generation(&untracked);
+		}
+		CHECK(same);
+
+		// The last level is a single block of the whole population.
+		size_t columns = 0;
+		const uint64_t* sums = grid_tile_sums(&tracked, 40, &columns);
+		CHECK(sums != nullptr && columns == 1);
+		CHECK(sums != nullptr && sums[0] == grid_stats(&tracked).population_);
+		CHECK(grid_tile_sums(&tracked, 0, &columns) == nullptr);
+		grid_free(&tracked);
+		grid_free(&untracked);
+	}
+}
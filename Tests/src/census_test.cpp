@@ -0,0 +1,58 @@
+// The census: objects named as apgsearch names them, and the same counts
+// whatever the number of threads.
+#include "test.hpp"
+#include <census.hpp>
+#include <utility>
+#include <vector>
+
+namespace
+{
+	typedef std::vector<std::pair<int64_t, int64_t>> cell_list;
+
+	// Moved somewhere else and turned a quarter: the same object.
+	cell_list turned(const cell_list& cells)
+	{
+		cell_list result;
+		for (const auto& cell : cells) result.push_back({ 100 - cell.second, cell.first - 40 });
+		return result;
+	}
+}
+
+TEST(census_identifies_objects)
+{
+	const cell_list block = { { 0, 0 }, { 1, 0 }, { 0, 1 }, { 1, 1 } };
+	const cell_list blinker = { { 0, 0 }, { 1, 0 }, { 2, 0 } };
+	const cell_list glider = { { 1, 0 }, { 2, 1 }, { 0, 2 }, { 1, 2 }, { 2, 2 } };
+	const cell_list beehive = { { 1, 0 }, { 2, 0 }, { 0, 1 }, { 3, 1 }, { 1, 2 }, { 2, 2 } };
+	const struct { const cell_list* cells_; const char* code_; } objects[] = {
+		{ &block, "xs4_33" }, { &blinker, "xp2_7" }, { &glider, "xq4_153" }, { &beehive, "xs6_696" },
+	};
+	for (const auto& object : objects) {
+		CHECK(census_identify(*object.cells_, rule_conway, 64) == object.code_);
+		CHECK(census_identify(turned(*object.cells_), rule_conway, 64) == object.code_);
+	}
+	// A lone cell dies: it does not come back.
+	CHECK(census_identify({ { 0, 0 } }, rule_conway, 64) == "");
+}
+
+TEST(census_same_for_any_thread_count)
+{
+	CensusOptions options = census_default_options(3, 300);
+	options.batch_size_ = 64;
+	options.thread_count_ = 1;
+	const Census one = census_run(options);
+	CHECK(one.soup_count_ == 300);
+	CHECK(one.objects_.count("xs4_33") == 1 && one.objects_.at("xs4_33") > 300);
+
+	const size_t thread_counts[] = { 2, 5, 0 };
+	for (size_t thread_count : thread_counts) {
+		options.thread_count_ = thread_count;
+		const Census many = census_run(options);
+		CHECK(many.objects_ == one.objects_);
+		CHECK(many.soup_count_ == one.soup_count_ && many.unsettled_count_ == one.unsettled_count_);
+	}
+
+	// Another seed, other soups.
+	options.seed_ = 4;
+	CHECK(census_run(options).objects_ != one.objects_);
+}
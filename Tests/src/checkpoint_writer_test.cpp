@@ -0,0 +1,61 @@
+// Checkpoints written in the background: what lands on disk, and failures reported back.
+#include "test.hpp"
+#include <checkpoint_writer.hpp>
+#include <grid.hpp>
+#include <grid_snapshot.hpp>
+#include <filesystem>
+#include <string>
+#include <stdio.h>
+
+namespace
+{
+	bool same_cells(const Grid* a, const Grid* b)
+	{
+		if (a->width_ != b->width_ || a->height_ != b->height_ || a->generation_ != b->generation_) return false;
+		for (size_t y = 0; y < a->height_; ++y)
+			for (size_t x = 0; x < a->width_; ++x)
+				if (get_cell(a, x, y) != get_cell(b, x, y)) return false;
+		return true;
+	}
+}
+
+TEST(checkpoints_hold_the_grid_as_it_was)
+{
+	const std::string path = (std::filesystem::temp_directory_path() / "conway_tests_checkpoint.snap").string();
+	for (int compress = 0; compress < 2; ++compress) {
+		Grid grid = grid_init(500, 300);
+		grid_randomize(&grid, 0.3, 11);
+		grid_set_thread_count(&grid, 3);
+		checkpoint_writer writer(1, compress != 0);
+		writer.checkpoint(&grid, path.c_str());
+		Grid then = grid_init(500, 300);
+		grid_randomize(&then, 0.3, 11);
+		// Stepped while the checkpoint may still be on its way to the disk.
+		grid_next_generations(&grid, 3);
+		CHECK(writer.flush());
+
+		Grid restored = grid_init(1, 1);
+		CHECK(grid_load_snapshot(&restored, path.c_str()));
+		CHECK(same_cells(&then, &restored));
+		grid_free(&restored);
+		grid_free(&then);
+		grid_free(&grid);
+	}
+	remove(path.c_str());
+}
+
+TEST(checkpoint_failures_are_reported)
+{
+	const std::string path = (std::filesystem::temp_directory_path() / "conway_tests_missing" / "checkpoint.snap").string();
+	Grid grid = grid_init(100, 100);
+	checkpoint_writer writer(2, true);
+	CHECK(writer.check());
+	writer.checkpoint(&grid, path.c_str());
+	CHECK(!writer.flush());
+	// Reported once.
+	CHECK(writer.flush());
+	CHECK(writer.check());
+	writer.checkpoint(&grid, path.c_str());
+	writer.flush();
+	grid_free(&grid);
+}
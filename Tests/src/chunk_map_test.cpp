@@ -0,0 +1,88 @@
+// The chunk map against the grid, and chunks following the live cells around.
+#include "test.hpp"
+#include <chunk_map.hpp>
+#include <grid.hpp>
+#include <random>
+
+namespace
+{
+	constexpr size_t board_size = 384;
+	// Grid cell (x, y) is chunk map cell (x - offset, y - offset): the soup lies
+	// across the origin, on chunks of both signs.
+	constexpr int64_t offset = board_size / 2 + 10;
+
+	bool same_cells(const Grid* grid, const ChunkMap* map)
+	{
+		uint64_t population = 0;
+		for (size_t y = 0; y < grid->height_; ++y) {
+			for (size_t x = 0; x < grid->width_; ++x) {
+				const bool alive = get_cell(grid, x, y);
+				if (alive != get_cell(map, static_cast<int64_t>(x) - offset, static_cast<int64_t>(y) - offset)) return false;
+				population += alive;
+			}
+		}
+		return population == chunk_map_population(map) && grid->generation_ == map->generation_;
+	}
+}
+
+TEST(chunk_map_matches_grid)
+{
+	const Rule rules[] = { rule_conway, rule_highlife };
+	std::mt19937_64 random(5);
+	for (Rule rule : rules) {
+		Grid grid = grid_init(board_size, board_size);
+		grid_set_rule(&grid, rule);
+		ChunkMap map = chunk_map_init();
+		chunk_map_set_rule(&map, rule);
+		// Far enough from the edges of the grid for 60 generations.
+		for (size_t y = board_size / 2 - 40; y < board_size / 2 + 40; ++y) {
+			for (size_t x = board_size / 2 - 40; x < board_size / 2 + 40; ++x) {
+				const bool alive = random() % 100 < 35;
+				write_cell(&grid, x, y, alive);
+				write_cell(&map, static_cast<int64_t>(x) - offset, static_cast<int64_t>(y) - offset, alive);
+			}
+		}
+		CHECK(same_cells(&grid, &map));
+		for (int round = 0; round < 6; ++round) {
+			grid_next_generations(&grid, 10);
+			if (round % 2 == 0) {
+				chunk_map_next_generations(&map, 10);
+			}
+			else {
+				for (int generation = 0; generation < 10; ++generation)
+					chunk_map_next_generation(&map);
+			}
+			CHECK(same_cells(&grid, &map));
+		}
+		chunk_map_free(&map);
+		grid_free(&grid);
+	}
+}
+
+TEST(chunk_map_frees_chunks_left_behind)
+{
+	ChunkMap map = chunk_map_init();
+	// A glider heading for negative x and y, from the corner of a chunk.
+	const int64_t glider[][2] = { { 1, 0 }, { 0, 1 }, { 2, 2 }, { 1, 2 }, { 0, 2 } };
+	for (const auto& cell : glider)
+		write_cell(&map, 60 + cell[0], 60 - cell[1], true);
+	for (int round = 0; round < 10; ++round) {
+		chunk_map_next_generations(&map, 200);
+		CHECK(chunk_map_population(&map) == 5);
+		// The chunks under it and the ones it is about to enter, not its trail.
+		CHECK(chunk_map_chunk_count(&map) <= 4);
+	}
+	// 2000 generations: 500 cells towards negative x and y.
+	for (const auto& cell : glider)
+		CHECK(get_cell(&map, 60 - 500 + cell[0], 60 - 500 - cell[1]));
+
+	// A lone cell dies, and takes its chunk with it.
+	ChunkMap lone = chunk_map_init();
+	write_cell(&lone, -1000, 5000, true);
+	CHECK(chunk_map_chunk_count(&lone) == 1);
+	chunk_map_next_generations(&lone, 3);
+	CHECK(chunk_map_population(&lone) == 0);
+	CHECK(chunk_map_chunk_count(&lone) == 0);
+	chunk_map_free(&lone);
+	chunk_map_free(&map);
+}
@@ -0,0 +1,106 @@
+// Board hashes, tracked tile by tile or not, and the periods the history finds with them.
+#include "test.hpp"
+#include <grid.hpp>
+#include <grid_history.hpp>
+
+namespace
+{
+	void write_cells(Grid* grid, size_t left, size_t top, const int (*cells)[2], size_t count)
+	{
+		for (size_t i = 0; i < count; ++i)
+			write_cell(grid, left + cells[i][0], top + cells[i][1], true);
+	}
+
+	const int glider[][2] = { { 1, 0 }, { 2, 1 }, { 0, 2 }, { 1, 2 }, { 2, 2 } };
+	const int blinker[][2] = { { 0, 1 }, { 1, 1 }, { 2, 1 } };
+	const int block[][2] = { { 0, 0 }, { 1, 0 }, { 0, 1 }, { 1, 1 } };
+}
+
+TEST(grid_hash_follows_the_cells)
+{
+	Grid tracked = grid_init(300, 200), untracked = grid_init(300, 200);
+	grid_randomize(&tracked, 0.3, 8);
+	grid_randomize(&untracked, 0.3, 8);
+	grid_track_hashes(&tracked, true);
+	CHECK(grid_hash(&tracked) == grid_hash(&untracked));
+	for (int generation = 0; generation < 30; ++generation) {
+		grid_next_generation(&tracked);
+		grid_next_generation(&untracked);
+		CHECK(grid_hash(&tracked) == grid_hash(&untracked));
+	}
+
+	// The same cells written into a fresh grid hash alike; one cell more does not.
+	Grid copy = grid_init(300, 200);
+	for (size_t y = 0; y < 200; ++y)
+		for (size_t x = 0; x < 300; ++x)
+			if (get_cell(&untracked, x, y)) write_cell(&copy, x, y, true);
+	CHECK(grid_hash(&copy) == grid_hash(&untracked));
+	const bool corner = get_cell(&copy, 299, 199);
+	write_cell(&copy, 299, 199, !corner);
+	CHECK(grid_hash(&copy) != grid_hash(&untracked));
+	write_cell(&copy, 299, 199, corner);
+	CHECK(grid_hash(&copy) == grid_hash(&untracked));
+
+	// Written cells reach the tracked hash with the next generation.
+	write_cell(&tracked, 10, 10, true);
+	write_cell(&untracked, 10, 10, true);
+	grid_next_generation(&tracked);
+	grid_next_generation(&untracked);
+	CHECK(grid_hash(&tracked) == grid_hash(&untracked));
+	grid_free(&copy);
+	grid_free(&untracked);
+	grid_free(&tracked);
+}
+
+TEST(grid_history_finds_periods)
+{
+	struct case_
+	{
+		const int (*cells_)[2];
+		size_t count_;
+		size_t size_;
+		grid_settling settling_;
+		uint64_t period_;
+	};
+	// On a torus, a glider comes back where it started after 4 generations per cell of the board.
+	const case_ cases[] = {
+		{ block, 4, 50, grid_settling::stable, 1 },
+		{ blinker, 3, 50, grid_settling::oscillating, 2 },
+		{ glider, 5, 16, grid_settling::oscillating, 64 },
+		{ glider, 5, 40, grid_settling::oscillating, 160 },
+		{ nullptr, 0, 50, grid_settling::stable, 1 },
+	};
+	for (const case_& c : cases) {
+		Grid grid = grid_init(c.size_, c.size_);
+		grid_set_boundary(&grid, grid_boundary::torus);
+		write_cells(&grid, 5, 5, c.cells_, c.count_);
+		grid_history history;
+		const GridPeriod period = grid_run_until_settled(&grid, &history, 1000);
+		CHECK(period.settling_ == c.settling_);
+		CHECK(period.period_ == c.period_);
+		// Found the first time the board came back.
+		CHECK(grid.generation_ == c.period_);
+		grid_free(&grid);
+	}
+
+	// Not settled yet: running, after exactly the generations allowed.
+	Grid grid = grid_init(200, 200);
+	grid_set_boundary(&grid, grid_boundary::torus);
+	write_cells(&grid, 5, 5, glider, 5);
+	grid_history history(64);
+	GridPeriod period = grid_run_until_settled(&grid, &history, 100);
+	CHECK(period.settling_ == grid_settling::running && period.period_ == 0);
+	CHECK(grid.generation_ == 100);
+
+	// After clear, nothing is remembered.
+	history.clear();
+	Grid still = grid_init(50, 50);
+	write_cells(&still, 5, 5, block, 4);
+	CHECK(history.observe(&still).settling_ == grid_settling::running);
+	CHECK(history.observe(&still).settling_ == grid_settling::running);
+	grid_next_generation(&still);
+	period = history.observe(&still);
+	CHECK(period.settling_ == grid_settling::stable && period.period_ == 1);
+	grid_free(&still);
+	grid_free(&grid);
+}
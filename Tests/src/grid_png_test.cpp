@@ -0,0 +1,104 @@
+// Boards saved as PNG and read back, and PNGs of other colour types read as boards.
+#include "test.hpp"
+#include <grid.hpp>
+#include <grid_png.hpp>
+#include <lodepng/lodepng.hpp>
+#include <filesystem>
+#include <string>
+#include <vector>
+#include <stdio.h>
+
+namespace
+{
+	std::string temp_path()
+	{
+		return (std::filesystem::temp_directory_path() / "conway_tests.png").string();
+	}
+}
+
+TEST(png_round_trips)
+{
+	struct size { size_t width_, height_; };
+	// Rows on and off a byte and a word, so that they start anywhere in a word of the image.
+	const size sizes[] = { { 1, 1 }, { 77, 50 }, { 64, 3 }, { 130, 65 } };
+	const std::string path = temp_path();
+	for (const size& size : sizes) {
+		Grid grid = grid_init(size.width_, size.height_);
+		grid_randomize(&grid, 0.5, size.width_);
+		CHECK(grid_save_png(&grid, path.c_str()));
+		Grid loaded = grid_init(size.width_, size.height_);
+		CHECK(grid_load_png(&loaded, path.c_str(), 0, 0));
+		bool same = true;
+		for (size_t y = 0; y < size.height_; ++y)
+			for (size_t x = 0; x < size.width_; ++x)
+				same &= get_cell(&grid, x, y) == get_cell(&loaded, x, y);
+		CHECK(same);
+
+		// Kept 1-bit greyscale, live cells white.
+		std::vector<unsigned char> image;
+		unsigned width, height;
+		CHECK(lodepng::decode(image, width, height, path, LCT_GREY, 8) == 0);
+		CHECK(width == size.width_ && height == size.height_);
+		CHECK(image.size() == size.width_ * size.height_ && (image[0] == 255) == get_cell(&grid, 0, 0));
+		grid_free(&loaded);
+		grid_free(&grid);
+	}
+	remove(path.c_str());
+}
+
+TEST(png_loaded_at_an_offset)
+{
+	const std::string path = temp_path();
+	Grid image = grid_init(70, 20);
+	grid_randomize(&image, 0.5, 4);
+	CHECK(grid_save_png(&image, path.c_str()));
+
+	const int64_t offsets[][2] = { { 5, 3 }, { -9, -4 }, { 60, 90 }, { -100, 0 }, { 90, 2 } };
+	for (const auto& offset : offsets) {
+		// Every cell alive beforehand: outside the image they stay so.
+		Grid grid = grid_init(100, 40);
+		for (size_t y = 0; y < grid.height_; ++y)
+			grid_fill_run(&grid, 0, y, grid.width_, true);
+		CHECK(grid_load_png(&grid, path.c_str(), offset[0], offset[1]));
+		bool same = true;
+		for (int64_t y = 0; y < 40; ++y) {
+			for (int64_t x = 0; x < 100; ++x) {
+				const int64_t image_x = x - offset[0], image_y = y - offset[1];
+				const bool inside = image_x >= 0 && image_x < 70 && image_y >= 0 && image_y < 20;
+				same &= get_cell(&grid, x, y) == (!inside || get_cell(&image, image_x, image_y));
+			}
+		}
+		CHECK(same);
+		grid_free(&grid);
+	}
+	remove(path.c_str());
+	grid_free(&image);
+}
+
+TEST(png_in_colour_read_by_brightness)
+{
+	const std::string path = temp_path();
+	// Black, white, dark red and light grey, over and over.
+	const unsigned char colours[4][4] = { { 0, 0, 0, 255 }, { 255, 255, 255, 255 }, { 90, 0, 0, 255 }, { 220, 220, 220, 255 } };
+	std::vector<unsigned char> pixels;
+	for (int i = 0; i < 9 * 5; ++i)
+		pixels.insert(pixels.end(), colours[i % 4], colours[i % 4] + 4);
+	CHECK(lodepng_encode32_file(path.c_str(), pixels.data(), 9, 5) == 0);
+
+	Grid grid = grid_init(9, 5);
+	CHECK(grid_load_png(&grid, path.c_str(), 0, 0));
+	bool same = true;
+	for (size_t i = 0; i < 9 * 5; ++i)
+		same &= get_cell(&grid, i % 9, i / 9) == (i % 4 == 1 || i % 4 == 3);
+	CHECK(same);
+
+	// Not a PNG at all.
+	FILE* file = fopen(path.c_str(), "wb");
+	if (file != nullptr) {
+		fputs("not a png", file);
+		fclose(file);
+	}
+	CHECK(!grid_load_png(&grid, path.c_str(), 0, 0));
+	remove(path.c_str());
+	grid_free(&grid);
+}
@@ -0,0 +1,174 @@
+// Snapshots: what comes back, saving over the file a grid was restored from, and broken headers.
+#include "test.hpp"
+#include <grid.hpp>
+#include <grid_snapshot.hpp>
+#include <filesystem>
+#include <string>
+#include <vector>
+#include <stdio.h>
+#include <string.h>
+
+namespace
+{
+	std::string temp_path(const char* name)
+	{
+		return (std::filesystem::temp_directory_path() / name).string();
+	}
+
+	bool same_grid(const Grid* a, const Grid* b)
+	{
+		if (a->width_ != b->width_ || a->height_ != b->height_ || a->generation_ != b->generation_ ||
+			!rule_equals(a->rule_, b->rule_) || a->boundary_ != b->boundary_) return false;
+		for (size_t y = 0; y < a->height_; ++y)
+			for (size_t x = 0; x < a->width_; ++x)
+				if (get_cell(a, x, y) != get_cell(b, x, y)) return false;
+		return true;
+	}
+
+	// A grid stepped a few generations under a rule and boundary of its own.
+	Grid sample_grid()
+	{
+		Grid grid = grid_init(300, 200);
+		grid_set_rule(&grid, rule_highlife);
+		grid_set_boundary(&grid, grid_boundary::torus);
+		// Only the top half: the bottom tile rows stay empty and have no stream.
+		for (size_t y = 0; y < 90; ++y)
+			for (size_t x = 0; x < 300; ++x)
+				write_cell(&grid, x, y, (x * 7 + y * 13) % 5 == 0);
+		grid_next_generations(&grid, 5);
+		return grid;
+	}
+
+	bool write_file(const std::string& path, const std::vector<uint8_t>& bytes)
+	{
+		FILE* file = fopen(path.c_str(), "wb");
+		if (file == nullptr) return false;
+		const bool ok = fwrite(bytes.data(), 1, bytes.size(), file) == bytes.size();
+		return fclose(file) == 0 && ok;
+	}
+
+	std::vector<uint8_t> read_file(const std::string& path)
+	{
+		std::vector<uint8_t> bytes;
+		FILE* file = fopen(path.c_str(), "rb");
+		if (file == nullptr) return bytes;
+		for (int c = fgetc(file); c != EOF; c = fgetc(file))
+			bytes.push_back(static_cast<uint8_t>(c));
+		fclose(file);
+		return bytes;
+	}
+}
+
+TEST(snapshot_round_trips)
+{
+	Grid grid = sample_grid();
+	const std::string path = temp_path("conway_tests_snapshot.snap");
+	for (int compressed = 0; compressed < 2; ++compressed) {
+		CHECK(compressed ? grid_save_compressed_snapshot(&grid, path.c_str()) : grid_save_snapshot(&grid, path.c_str()));
+		Grid restored = grid_init(1, 1);
+		CHECK(grid_load_snapshot(&restored, path.c_str()));
+		CHECK(same_grid(&grid, &restored));
+		CHECK((restored.mapping_ != nullptr) == !compressed);
+
+		// Both step on the same.
+		grid_next_generations(&restored, 7);
+		Grid stepped = sample_grid();
+		grid_next_generations(&stepped, 7);
+		CHECK(same_grid(&stepped, &restored));
+		grid_free(&stepped);
+		grid_free(&restored);
+	}
+	remove(path.c_str());
+	grid_free(&grid);
+}
+
+TEST(snapshot_saved_over_the_file_it_was_restored_from)
+{
+	Grid grid = sample_grid();
+	const std::string path = temp_path("conway_tests_resumed.snap");
+	CHECK(grid_save_snapshot(&grid, path.c_str()));
+	Grid resumed = grid_init(1, 1);
+	CHECK(grid_load_snapshot(&resumed, path.c_str()));
+	grid_track_stats(&resumed, true);
+
+	for (int save = 0; save < 3; ++save) {
+		grid_next_generation(&resumed);
+		grid_next_generation(&grid);
+		grid_release_mapping(&resumed);
+		CHECK(resumed.mapping_ == nullptr);
+		CHECK(same_grid(&grid, &resumed));
+		CHECK(save % 2 == 0 ? grid_save_snapshot(&resumed, path.c_str()) : grid_save_compressed_snapshot(&resumed, path.c_str()));
+	}
+	Grid reread = grid_init(1, 1);
+	CHECK(grid_load_snapshot(&reread, path.c_str()));
+	CHECK(same_grid(&grid, &reread));
+	grid_free(&reread);
+	grid_free(&resumed);
+	remove(path.c_str());
+	grid_free(&grid);
+}
+
+TEST(snapshot_headers_out_of_range_are_refused)
+{
+	Grid grid = sample_grid();
+	const std::string path = temp_path("conway_tests_header.snap");
+	CHECK(grid_save_compressed_snapshot(&grid, path.c_str()));
+	const std::vector<uint8_t> bytes = read_file(path);
+	CHECK(bytes.size() > sizeof(GridSnapshotHeader));
+	GridSnapshotHeader header;
+	memcpy(&header, bytes.data(), sizeof header);
+
+	auto loads_with = [&](auto change) {
+		GridSnapshotHeader changed = header;
+		change(changed);
+		std::vector<uint8_t> crafted = bytes;
+		memcpy(crafted.data(), &changed, sizeof changed);
+		if (!write_file(path, crafted)) return true;
+		Grid loaded = grid_init(1, 1);
+		const bool loaded_ok = grid_load_snapshot(&loaded, path.c_str());
+		grid_free(&loaded);
+		return loaded_ok;
+	};
+	CHECK(loads_with([](GridSnapshotHeader&) {}));
+	// The stride of a width this close to 2^64 wraps around to that of a tiny board.
+	CHECK(!loads_with([](GridSnapshotHeader& h) { h.width_ = UINT64_MAX - 10; h.stride_ = (h.width_ + 63) / 64 + 2; }));
+	CHECK(!loads_with([](GridSnapshotHeader& h) { h.height_ = uint64_t(1) << 50; }));
+	// Empty tile rows are free in a compressed file: a board far too large to allocate.
+	CHECK(!loads_with([](GridSnapshotHeader& h) { h.width_ = uint64_t(1) << 39; h.stride_ = (h.width_ + 63) / 64 + 2; }));
+	CHECK(!loads_with([](GridSnapshotHeader& h) { h.stride_ += 1; }));
+	CHECK(!loads_with([](GridSnapshotHeader& h) { h.birth_ = 1; }));
+	remove(path.c_str());
+	grid_free(&grid);
+}
+
+TEST(snapshot_compressed_files)
+{
+	Grid grid = sample_grid();
+	const std::string plain_path = temp_path("conway_tests_plain.snap");
+	const std::string path = temp_path("conway_tests_compressed.snap");
+	CHECK(grid_save_snapshot(&grid, plain_path.c_str()));
+	CHECK(grid_save_compressed_snapshot(&grid, path.c_str()));
+	const std::vector<uint8_t> bytes = read_file(path);
+	CHECK(bytes.size() * 2 < read_file(plain_path).size());
+
+	// The same file however many threads compress it.
+	grid_set_thread_count(&grid, 3);
+	CHECK(grid_save_compressed_snapshot(&grid, path.c_str()));
+	CHECK(read_file(path) == bytes);
+
+	// Damaged or cut short, it is refused and the grid left as it was.
+	std::vector<uint8_t> damaged = bytes;
+	damaged[damaged.size() - 20] ^= 0x5a;
+	std::vector<uint8_t> truncated(bytes.begin(), bytes.end() - 30);
+	for (const std::vector<uint8_t>* file : { &damaged, &truncated }) {
+		CHECK(write_file(path, *file));
+		Grid loaded = grid_init(7, 9);
+		write_cell(&loaded, 3, 4, true);
+		CHECK(!grid_load_snapshot(&loaded, path.c_str()));
+		CHECK(loaded.width_ == 7 && loaded.height_ == 9 && get_cell(&loaded, 3, 4));
+		grid_free(&loaded);
+	}
+	remove(plain_path.c_str());
+	remove(path.c_str());
+	grid_free(&grid);
+}
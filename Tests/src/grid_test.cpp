@@ -0,0 +1,226 @@
+// The grid against a naive stepper that counts the neighbours of every cell,
+// for every kernel this machine runs.
+#include "test.hpp"
+#include <grid.hpp>
+#include <grid_kernel.hpp>
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <stdio.h>
+#include <vector>
+
+namespace
+{
+	// The cells of a board, one byte per cell, stepped the slow and obvious way.
+	struct reference_board
+	{
+		int64_t width_, height_;
+		std::vector<uint8_t> cells_;
+
+		uint8_t cell(int64_t x, int64_t y, grid_boundary boundary) const
+		{
+			const bool outside = x < 0 || x >= width_ || y < 0 || y >= height_;
+			if (outside) {
+				switch (boundary) {
+				case grid_boundary::dead:
+					return 0;
+				case grid_boundary::torus:
+					x = (x + width_) % width_;
+					y = (y + height_) % height_;
+					break;
+				case grid_boundary::mirror:
+					x = std::clamp<int64_t>(x, 0, width_ - 1);
+					y = std::clamp<int64_t>(y, 0, height_ - 1);
+					break;
+				case grid_boundary::klein_bottle:
+					// Across the top or bottom edge comes the other edge, left to right flipped.
+					if (y < 0 || y >= height_) {
+						y = (y + height_) % height_;
+						x = width_ - 1 - x;
+					}
+					x = (x + width_) % width_;
+					break;
+				}
+			}
+			return cells_[y * width_ + x];
+		}
+
+		void step(Rule rule, grid_boundary boundary)
+		{
+			std::vector<uint8_t> next(cells_.size());
+			for (int64_t y = 0; y < height_; ++y) {
+				for (int64_t x = 0; x < width_; ++x) {
+					uint32_t neighbours = 0;
+					for (int64_t dy = -1; dy <= 1; ++dy)
+						for (int64_t dx = -1; dx <= 1; ++dx)
+							if (dx != 0 || dy != 0) neighbours += cell(x + dx, y + dy, boundary);
+					const uint32_t mask = cells_[y * width_ + x] ? rule.survival_ : rule.birth_;
+					next[y * width_ + x] = (mask >> neighbours) & 1;
+				}
+			}
+			cells_.swap(next);
+		}
+	};
+
+	bool same_cells(const Grid* grid, const reference_board& board)
+	{
+		for (int64_t y = 0; y < board.height_; ++y)
+			for (int64_t x = 0; x < board.width_; ++x)
+				if (get_cell(grid, x, y) != (board.cells_[y * board.width_ + x] != 0)) return false;
+		return true;
+	}
+
+	// Soups in a few rectangles of the board, the rest dead, so that tiles are skipped as well as stepped.
+	void scatter_soups(Grid* grid, reference_board* board, std::mt19937_64& random)
+	{
+		for (int soup = 0; soup < 3; ++soup) {
+			const int64_t x0 = random() % board->width_, y0 = random() % board->height_;
+			const int64_t x1 = std::min<int64_t>(x0 + 1 + random() % 40, board->width_);
+			const int64_t y1 = std::min<int64_t>(y0 + 1 + random() % 40, board->height_);
+			for (int64_t y = y0; y < y1; ++y) {
+				for (int64_t x = x0; x < x1; ++x) {
+					const bool alive = random() % 100 < 40;
+					write_cell(grid, x, y, alive);
+					board->cells_[y * board->width_ + x] = alive;
+				}
+			}
+		}
+	}
+
+	// A random rule without B0, the other bits as likely set as not.
+	Rule random_rule(std::mt19937_64& random)
+	{
+		return Rule{ .birth_ = static_cast<uint32_t>(random() & 0b111111110), .survival_ = static_cast<uint32_t>(random() & 0b111111111) };
+	}
+}
+
+TEST(kernels_match_naive_stepper)
+{
+	struct size { size_t width_, height_; };
+	// Widths on and off a word, heights on and off a tile, down to a single column.
+	const size sizes[] = { { 1, 5 }, { 5, 1 }, { 63, 70 }, { 64, 64 }, { 65, 129 }, { 130, 67 }, { 200, 150 } };
+	const grid_boundary boundaries[] = { grid_boundary::dead, grid_boundary::torus, grid_boundary::mirror, grid_boundary::klein_bottle };
+	const size_t thread_counts[] = { 1, 3 };
+	const kernel_isa isas[] = { kernel_isa::scalar, kernel_isa::sse2, kernel_isa::avx2, kernel_isa::avx512 };
+	constexpr int generations = 12;
+
+	const kernel_isa previous = grid_active_kernel();
+	std::mt19937_64 random(1);
+	for (kernel_isa isa : isas) {
+		if (isa > kernel_isa_detect()) continue;
+		grid_use_kernel(isa);
+		for (const size& size : sizes) {
+			for (grid_boundary boundary : boundaries) {
+				const Rule rules[] = { rule_conway, rule_highlife, random_rule(random) };
+				for (Rule rule : rules) {
+					for (size_t thread_count : thread_counts) {
+						Grid grid = grid_init(size.width_, size.height_);
+						grid_set_rule(&grid, rule);
+						grid_set_boundary(&grid, boundary);
+						grid_set_thread_count(&grid, thread_count);
+						reference_board board{ static_cast<int64_t>(size.width_), static_cast<int64_t>(size.height_),
+							std::vector<uint8_t>(size.width_ * size.height_) };
+						scatter_soups(&grid, &board, random);
+
+						bool same = true;
+						for (int generation = 0; generation < generations && same; ++generation) {
+							// More soup halfway through, into tiles that may have settled.
+							if (generation == generations / 2) scatter_soups(&grid, &board, random);
+							grid_next_generation(&grid);
+							board.step(rule, boundary);
+							same = same_cells(&grid, board);
+						}
+						if (!same) {
+							char rule_text[rule_text_size];
+							rule_format(rule, rule_text);
+							fprintf(stderr, "  %s kernel, %zux%zu, boundary %d, %s, %zu threads\n", kernel_isa_name(isa),
+								size.width_, size.height_, static_cast<int>(boundary), rule_text, thread_count);
+						}
+						CHECK(same);
+						grid_free(&grid);
+					}
+				}
+			}
+		}
+	}
+	grid_use_kernel(previous);
+}
+
+TEST(stats_of_cells_cleared_after_a_generation)
+{
+	Grid grid = grid_init(1024, 1024);
+	grid_randomize(&grid, 0.3, 7);
+	grid_track_stats(&grid, true);
+	grid_next_generation(&grid);
+	for (size_t y = 0; y < grid.height_; ++y)
+		grid_fill_run(&grid, 0, y, grid.width_, false);
+
+	const GridStats stats = grid_stats(&grid);
+	CHECK(stats.population_ == 0);
+	CHECK(stats.min_x_ > stats.max_x_);
+	CHECK(stats.min_y_ > stats.max_y_);
+	grid_free(&grid);
+}
+
+TEST(randomize_same_cells_for_any_thread_count_and_kernel)
+{
+	const kernel_isa isas[] = { kernel_isa::scalar, kernel_isa::sse2, kernel_isa::avx2, kernel_isa::avx512 };
+	const double densities[] = { 0.5, 0.3, 0.123456789, 1.0 / 4096 };
+	const kernel_isa previous = grid_active_kernel();
+	// Off a word and off a register of words, so rows end in part of one.
+	constexpr size_t width = 64 * 11 + 37, height = 150;
+	for (double density : densities) {
+		Grid reference = grid_init(width, height);
+		grid_use_kernel(kernel_isa::scalar);
+		grid_randomize(&reference, density, 99);
+		uint64_t population = 0;
+		for (size_t y = 0; y < height; ++y)
+			for (size_t x = 0; x < width; ++x)
+				population += get_cell(&reference, x, y);
+		// Within five standard deviations of what density makes likely.
+		const double expected = density * width * height;
+		CHECK(population > expected - 5 * std::sqrt(expected) && population < expected + 5 * std::sqrt(expected) + 1);
+
+		for (kernel_isa isa : isas) {
+			if (isa > kernel_isa_detect()) continue;
+			grid_use_kernel(isa);
+			for (size_t thread_count : { 1, 3, 8 }) {
+				Grid grid = grid_init(width, height);
+				grid_set_thread_count(&grid, thread_count);
+				grid_randomize(&grid, density, 99);
+				bool same = true;
+				for (size_t y = 0; y < height; ++y)
+					for (size_t x = 0; x < width; ++x)
+						same &= get_cell(&grid, x, y) == get_cell(&reference, x, y);
+				CHECK(same);
+				// Nothing past the last column.
+				CHECK(grid_hash(&grid) == grid_hash(&reference));
+				grid_free(&grid);
+			}
+		}
+		grid_free(&reference);
+	}
+	grid_use_kernel(previous);
+
+	// A density of nothing, or of not a number, kills every cell; 1 or more brings them all to life.
+	Grid grid = grid_init(100, 70);
+	const double dead[] = { 0.0, -1.0, std::nan("") }, alive[] = { 1.0, 7.5 };
+	for (double density : dead) {
+		grid_randomize(&grid, 1.0, 5);
+		grid_randomize(&grid, density, 5);
+		bool none = true;
+		for (size_t y = 0; y < 70; ++y)
+			for (size_t x = 0; x < 100; ++x)
+				none &= !get_cell(&grid, x, y);
+		CHECK(none);
+	}
+	for (double density : alive) {
+		grid_randomize(&grid, density, 5);
+		bool all = true;
+		for (size_t y = 0; y < 70; ++y)
+			for (size_t x = 0; x < 100; ++x)
+				all &= get_cell(&grid, x, y);
+		CHECK(all);
+	}
+	grid_free(&grid);
+}
@@ -0,0 +1,178 @@
+// HashLife against the grid, on soups far enough from the edges of the board
+// never to reach them, and macrocell files.
+#include "test.hpp"
+#include <grid.hpp>
+#include <hashlife.hpp>
+#include <filesystem>
+#include <random>
+#include <string>
+#include <stdio.h>
+
+namespace
+{
+	constexpr size_t board_size = 512;
+
+	// A 48 by 48 soup in the middle of an otherwise dead board.
+	Grid soup_grid(Rule rule, uint64_t seed)
+	{
+		Grid grid = grid_init(board_size, board_size);
+		grid_set_rule(&grid, rule);
+		std::mt19937_64 random(seed);
+		for (size_t y = board_size / 2 - 24; y < board_size / 2 + 24; ++y)
+			for (size_t x = board_size / 2 - 24; x < board_size / 2 + 24; ++x)
+				write_cell(&grid, x, y, random() % 100 < 40);
+		return grid;
+	}
+
+	bool same_cells(const Grid* grid, const HashLife* life)
+	{
+		uint64_t population = 0;
+		for (size_t y = 0; y < grid->height_; ++y) {
+			for (size_t x = 0; x < grid->width_; ++x) {
+				const bool alive = get_cell(grid, x, y);
+				if (alive != get_cell(life, static_cast<int64_t>(x), static_cast<int64_t>(y))) return false;
+				population += alive;
+			}
+		}
+		// Nothing off the board either.
+		return population == hashlife_population(life) && grid->generation_ == life->generation_;
+	}
+}
+
+TEST(hashlife_matches_grid)
+{
+	const Rule rules[] = { rule_conway, rule_highlife };
+	for (Rule rule : rules) {
+		for (uint64_t seed = 1; seed <= 3; ++seed) {
+			Grid grid = soup_grid(rule, seed);
+			HashLife life = hashlife_from_grid(&grid);
+			CHECK(same_cells(&grid, &life));
+
+			for (int generation = 0; generation < 5; ++generation) {
+				hashlife_next_generation(&life);
+				grid_next_generation(&grid);
+			}
+			CHECK(same_cells(&grid, &life));
+
+			// Counts of many powers of two, one after the other and over again.
+			const uint64_t counts[] = { 13, 32, 27, 13, 1, 40 };
+			for (uint64_t count : counts) {
+				hashlife_next_generations(&life, count);
+				grid_next_generations(&grid, count);
+				CHECK(same_cells(&grid, &life));
+			}
+			hashlife_free(&life);
+			grid_free(&grid);
+		}
+	}
+}
+
+TEST(hashlife_cells_written_anywhere)
+{
+	HashLife life = hashlife_init();
+	// A glider far out on both sides of the origin, which grows the root.
+	const int64_t far = int64_t(1) << 40;
+	const int64_t glider[][2] = { { 1, 0 }, { 2, 1 }, { 0, 2 }, { 1, 2 }, { 2, 2 } };
+	for (const auto& cell : glider) {
+		write_cell(&life, -far + cell[0], far + cell[1], true);
+		write_cell(&life, far + cell[0], -far + cell[1], true);
+	}
+	CHECK(hashlife_population(&life) == 10);
+	CHECK(get_cell(&life, -far + 1, far));
+	CHECK(!get_cell(&life, -far, far));
+
+	// A glider moves a cell down and to the right every four generations.
+	hashlife_advance_pow2(&life, 10);
+	CHECK(life.generation_ == 1024);
+	CHECK(hashlife_population(&life) == 10);
+	for (const auto& cell : glider) {
+		CHECK(get_cell(&life, -far + 256 + cell[0], far + 256 + cell[1]));
+		CHECK(get_cell(&life, far + 256 + cell[0], -far + 256 + cell[1]));
+	}
+	write_cell(&life, far + 256 + 1, -far + 256, false);
+	CHECK(hashlife_population(&life) == 9);
+	hashlife_free(&life);
+}
+
+TEST(hashlife_macrocell_round_trips)
+{
+	const std::string path = (std::filesystem::temp_directory_path() / "conway_tests.mc").string();
+	Grid grid = soup_grid(rule_highlife, 9);
+	HashLife life = hashlife_from_grid(&grid);
+	hashlife_next_generations(&life, 100);
+	// Far from the soup, and 4096 copies of a block, which share their nodes.
+	for (int64_t y = 0; y < 64; ++y) {
+		for (int64_t x = 0; x < 64; ++x) {
+			const int64_t left = (int64_t(1) << 30) + x * 8, top = -(int64_t(1) << 30) + y * 8;
+			write_cell(&life, left, top, true);
+			write_cell(&life, left + 1, top, true);
+			write_cell(&life, left, top + 1, true);
+			write_cell(&life, left + 1, top + 1, true);
+		}
+	}
+	CHECK(hashlife_write_macrocell(&life, path.c_str()));
+
+	HashLife read = hashlife_init();
+	CHECK(hashlife_read_macrocell(&read, path.c_str()));
+	CHECK(rule_equals(read.rule_, rule_highlife));
+	CHECK(read.generation_ == life.generation_);
+	CHECK(hashlife_population(&read) == hashlife_population(&life));
+	bool same = true;
+	for (int64_t y = 0; y < static_cast<int64_t>(board_size) && same; ++y)
+		for (int64_t x = 0; x < static_cast<int64_t>(board_size) && same; ++x)
+			same = get_cell(&read, x, y) == get_cell(&life, x, y);
+	for (int64_t y = 0; y < 520 && same; ++y)
+		for (int64_t x = 0; x < 520 && same; ++x)
+			same = get_cell(&read, (int64_t(1) << 30) + x, -(int64_t(1) << 30) + y) == get_cell(&life, (int64_t(1) << 30) + x, -(int64_t(1) << 30) + y);
+	CHECK(same);
+	// And on from there alike.
+	hashlife_next_generations(&read, 50);
+	hashlife_next_generations(&life, 50);
+	CHECK(hashlife_population(&read) == hashlife_population(&life));
+
+	// Every shared node once: the blocks take a few lines, not thousands.
+	FILE* file = fopen(path.c_str(), "rb");
+	size_t lines = 0;
+	for (int c; file != nullptr && (c = fgetc(file)) != EOF;) lines += c == '\n';
+	if (file != nullptr) fclose(file);
+	CHECK(lines < 5000);
+	remove(path.c_str());
+	hashlife_free(&read);
+	hashlife_free(&life);
+	grid_free(&grid);
+}
+
+TEST(hashlife_macrocell_from_golly)
+{
+	const std::string path = (std::filesystem::temp_directory_path() / "conway_tests.mc").string();
+	auto read_text = [&](const char* text, HashLife* life) {
+		FILE* file = fopen(path.c_str(), "wb");
+		if (file == nullptr) return false;
+		fputs(text, file);
+		fclose(file);
+		return hashlife_read_macrocell(life, path.c_str());
+	};
+
+	// A glider in the north-west leaf of a 16 by 16 root, which covers [-8, 8).
+	HashLife life = hashlife_init();
+	CHECK(read_text("[M2] (golly 4.2)\n#R B3/S23\n#G 12\n.*$..*$***$\n4 1 0 0 0\n", &life));
+	CHECK(life.generation_ == 12);
+	CHECK(hashlife_population(&life) == 5);
+	CHECK(get_cell(&life, -7, -8) && get_cell(&life, -6, -7));
+	CHECK(get_cell(&life, -8, -6) && get_cell(&life, -7, -6) && get_cell(&life, -6, -6));
+
+	// Refused, leaving the universe alone.
+	const char* refused[] = {
+		"[M1]\n.*$\n",
+		"[M2]\n#R B3/S23\n.*$\n4 2 0 0 0\n",
+		"[M2]\n.*$\n5 1 0 0 0\n",
+		"[M2]\n.*$..x$\n",
+		"[M2]\n#R LifeHistory\n.*$\n4 1 0 0 0\n",
+	};
+	for (const char* text : refused) {
+		CHECK(!read_text(text, &life));
+		CHECK(hashlife_population(&life) == 5 && life.generation_ == 12);
+	}
+	remove(path.c_str());
+	hashlife_free(&life);
+}
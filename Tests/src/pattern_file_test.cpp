@@ -0,0 +1,141 @@
+// The RLE, plaintext and Life 1.06 loaders, on small files written for the purpose.
+#include "test.hpp"
+#include <grid.hpp>
+#include <pattern_file.hpp>
+#include <algorithm>
+#include <filesystem>
+#include <string>
+#include <utility>
+#include <vector>
+#include <stdio.h>
+
+namespace
+{
+	typedef std::vector<std::pair<int64_t, int64_t>> cell_list;
+
+	std::string write_pattern(const char* text)
+	{
+		const std::string path = (std::filesystem::temp_directory_path() / "conway_tests_pattern.txt").string();
+		FILE* file = fopen(path.c_str(), "wb");
+		if (file != nullptr) {
+			fputs(text, file);
+			fclose(file);
+		}
+		return path;
+	}
+
+	// The live cells of a pattern file, sorted by row, or nothing if it does not read.
+	bool read_cells(const char* text, cell_list* cells, PatternInfo* info)
+	{
+		cells->clear();
+		const std::string path = write_pattern(text);
+		const bool ok = pattern_read(path.c_str(), [cells](int64_t x, int64_t y, uint64_t length) {
+			for (uint64_t i = 0; i < length; ++i)
+				cells->push_back({ y, x + static_cast<int64_t>(i) });
+		}, info);
+		remove(path.c_str());
+		std::sort(cells->begin(), cells->end());
+		return ok;
+	}
+
+	// The same cells, given as (x, y).
+	bool same_cells(const cell_list& cells, cell_list expected)
+	{
+		for (auto& cell : expected) std::swap(cell.first, cell.second);
+		std::sort(expected.begin(), expected.end());
+		return cells == expected;
+	}
+
+	const cell_list glider = { { 1, 0 }, { 2, 1 }, { 0, 2 }, { 1, 2 }, { 2, 2 } };
+}
+
+TEST(pattern_rle)
+{
+	cell_list cells;
+	PatternInfo info;
+	CHECK(read_cells("#N Glider\n#C a comment\nx = 3, y = 3, rule = B3/S23\nbob$2bo$3o!\n", &cells, &info));
+	CHECK(info.format_ == pattern_format::rle);
+	CHECK(same_cells(cells, glider));
+	CHECK(info.rule_valid_ && rule_equals(info.rule_, rule_conway));
+	CHECK(info.population_ == 5);
+	CHECK(info.min_x_ == 0 && info.min_y_ == 0 && info.max_x_ == 2 && info.max_y_ == 2);
+
+	// Runs and row counts over several lines, a Golly bounded grid after the rule, and a position.
+	CHECK(read_cells("#CXRLE Pos=-10,20\nx = 12, y = 4, rule = B36/S23:T100,100\n12o$\n\n2$3bo\n2o!\nignored\n", &cells, &info));
+	cell_list expected;
+	for (int64_t x = 0; x < 12; ++x) expected.push_back({ x - 10, 20 });
+	expected.push_back({ 3 - 10, 23 });
+	expected.push_back({ 4 - 10, 23 });
+	expected.push_back({ 5 - 10, 23 });
+	CHECK(same_cells(cells, expected));
+	CHECK(info.rule_valid_ && rule_equals(info.rule_, rule_highlife));
+	CHECK(info.rule_text_ == "B36/S23:T100,100");
+
+	// A rule that is not Life-like is kept as text only.
+	CHECK(read_cells("x = 1, y = 1, rule = LifeHistory\nA!\n", &cells, &info));
+	CHECK(!info.rule_valid_ && info.rule_text_ == "LifeHistory");
+	CHECK(same_cells(cells, { { 0, 0 } }));
+
+	CHECK(!read_cells("x = 3, y = 3\nbo%b!\n", &cells, &info));
+	CHECK(!read_cells("x = 3, y = 3\n99999999999999o!\n", &cells, &info));
+}
+
+TEST(pattern_rle_multi_state_cells)
+{
+	cell_list cells;
+	PatternInfo info;
+	// States past 24 take two letters: pA is one cell of state 25, yO one of 255.
+	CHECK(read_cells("x = 6, y = 2, rule = Generations\n.pA2B.yO$2pX.qa!\n", &cells, &info));
+	CHECK(same_cells(cells, { { 1, 0 }, { 2, 0 }, { 3, 0 }, { 5, 0 }, { 0, 1 }, { 1, 1 }, { 3, 1 }, { 4, 1 } }));
+	CHECK(info.population_ == 8);
+}
+
+TEST(pattern_plaintext)
+{
+	cell_list cells;
+	PatternInfo info;
+	CHECK(read_cells("!Name: Glider\n!\n.O\n..O\nOOO\n", &cells, &info));
+	CHECK(info.format_ == pattern_format::plaintext);
+	CHECK(same_cells(cells, glider));
+	CHECK(!info.rule_valid_);
+
+	// Empty rows count, and '*' is alive too.
+	CHECK(read_cells("*.*\n\n..*\r\n", &cells, &info));
+	CHECK(same_cells(cells, { { 0, 0 }, { 2, 0 }, { 2, 2 } }));
+	CHECK(!read_cells(".O.\n.X.\n", &cells, &info));
+}
+
+TEST(pattern_life_106)
+{
+	cell_list cells;
+	PatternInfo info;
+	CHECK(read_cells("#Life 1.06\n1 0\n2 1\n#P comment\n0 2\n1 2\n\n2 2\n", &cells, &info));
+	CHECK(info.format_ == pattern_format::life_106);
+	CHECK(same_cells(cells, glider));
+	CHECK(read_cells("#Life 1.06\n-5 -7\n3000000000 4\n", &cells, &info));
+	CHECK(same_cells(cells, { { -5, -7 }, { 3000000000, 4 } }));
+	CHECK(info.min_x_ == -5 && info.min_y_ == -7 && info.max_x_ == 3000000000 && info.max_y_ == 4);
+	CHECK(!read_cells("#Life 1.06\n1\n", &cells, &info));
+}
+
+TEST(pattern_loaded_into_grid)
+{
+	const std::string path = write_pattern("x = 3, y = 3\nbob$2bo$3o!\n");
+	Grid grid = grid_init(10, 10);
+	PatternInfo info;
+	CHECK(grid_load_pattern(&grid, path.c_str(), 4, 5, &info));
+	// Cut off by the edges: only the cells on the board.
+	CHECK(grid_load_pattern(&grid, path.c_str(), -1, 8, &info));
+	remove(path.c_str());
+
+	cell_list expected;
+	for (const auto& cell : glider) expected.push_back({ cell.first + 4, cell.second + 5 });
+	expected.push_back({ 0, 8 });
+	expected.push_back({ 1, 9 });
+	cell_list cells;
+	for (size_t y = 0; y < grid.height_; ++y)
+		for (size_t x = 0; x < grid.width_; ++x)
+			if (get_cell(&grid, x, y)) cells.push_back({ static_cast<int64_t>(y), static_cast<int64_t>(x) });
+	CHECK(same_cells(cells, expected));
+	grid_free(&grid);
+}
@@ -0,0 +1,94 @@
+// Rule notation, and the kernels specialised for common rules against the
+// table the others run on.
+#include "test.hpp"
+#include <grid.hpp>
+#include <grid_kernel.hpp>
+#include <rule.hpp>
+#include <string.h>
+
+namespace
+{
+	bool parses_to(const char* text, Rule expected)
+	{
+		Rule rule = { 0, 0 };
+		return rule_parse(text, &rule) && rule_equals(rule, expected);
+	}
+
+	bool formats_to(Rule rule, const char* expected)
+	{
+		char text[rule_text_size];
+		rule_format(rule, text);
+		return strcmp(text, expected) == 0;
+	}
+}
+
+TEST(rule_notation)
+{
+	CHECK(parses_to("B3/S23", rule_conway));
+	CHECK(parses_to("b3s23", rule_conway));
+	CHECK(parses_to("23/3", rule_conway));
+	CHECK(parses_to("B36/S23", rule_highlife));
+	CHECK(parses_to("B3678/S34678", rule_day_night));
+	CHECK(parses_to("B2/S", rule_seeds));
+	CHECK(parses_to("/2", rule_seeds));
+	CHECK(parses_to("B/S012345678", (Rule{ 0, 0b111111111 })));
+
+	// Refused, leaving the rule alone.
+	const char* refused[] = { "", "B3", "S23", "B3/23", "B39/S23", "B3/S23x", "3/23/", "B03/S23", "023/0", "B3 /S23" };
+	for (const char* text : refused) {
+		Rule rule = rule_highlife;
+		CHECK(!rule_parse(text, &rule));
+		CHECK(rule_equals(rule, rule_highlife));
+	}
+
+	CHECK(formats_to(rule_conway, "B3/S23"));
+	CHECK(formats_to(rule_seeds, "B2/S"));
+	CHECK(formats_to(Rule{ 0b111111110, 0b111111111 }, "B12345678/S012345678"));
+	// The longest there is fits.
+	CHECK(strlen("B12345678/S012345678") + 1 <= rule_text_size);
+
+	// Every rule without B0 reads back as itself.
+	for (uint32_t birth = 0; birth < 512; birth += 2) {
+		for (uint32_t survival = 0; survival < 512; survival += 37) {
+			const Rule rule = { birth, survival };
+			char text[rule_text_size];
+			rule_format(rule, text);
+			CHECK(parses_to(text, rule));
+		}
+	}
+}
+
+TEST(rule_specialised_kernels_match_table)
+{
+	const Rule rules[] = { rule_conway, rule_highlife, rule_day_night, rule_seeds };
+	const kernel_isa isas[] = { kernel_isa::scalar, kernel_isa::sse2, kernel_isa::avx2, kernel_isa::avx512 };
+	const kernel_isa previous = grid_active_kernel();
+	for (kernel_isa isa : isas) {
+		if (isa > kernel_isa_detect()) continue;
+		grid_use_kernel(isa);
+		for (Rule rule : rules) {
+			// Birth on nine neighbours never happens, but takes the rule off the specialised kernels.
+			const Rule table_rule = { rule.birth_ | (uint32_t(1) << 9), rule.survival_ };
+			Grid specialised = grid_init(300, 200), table = grid_init(300, 200);
+			grid_randomize(&specialised, 0.4, 3);
+			grid_randomize(&table, 0.4, 3);
+			grid_set_rule(&specialised, rule);
+			grid_set_rule(&table, table_rule);
+			grid_set_boundary(&specialised, grid_boundary::torus);
+			grid_set_boundary(&table, grid_boundary::torus);
+
+			bool same = true;
+			for (int generation = 0; generation < 20 && same; ++generation) {
+				grid_next_generation(&specialised);
+				grid_next_generation(&table);
+				for (size_t y = 0; y < 200 && same; ++y)
+					for (size_t x = 0; x < 300 && same; ++x)
+						same = get_cell(&specialised, x, y) == get_cell(&table, x, y);
+			}
+			CHECK(same);
+			grid_free(&table);
+			grid_free(&specialised);
+		}
+	}
+	grid_use_kernel(previous);
+}
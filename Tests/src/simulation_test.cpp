@@ -0,0 +1,100 @@
+// The simulation thread: what it publishes, and that settings never wait for a step.
+#include "test.hpp"
+#include <simulation.hpp>
+#include <chrono>
+#include <thread>
+
+using namespace std::chrono_literals;
+
+TEST(simulation_publishes_the_generation_it_paused_at)
+{
+	Grid grid = grid_init(256, 256);
+	grid_randomize(&grid, 0.3, 3);
+	const board_view view = board_view_fit(256, 256, 256, 256);
+	for (int pause = 0; pause < 10; ++pause) {
+		uint64_t shown = 0;
+		{
+			// As fast as it goes: most generations are never published.
+			simulation sim(&grid, 0, step_speed(), view, nullptr);
+			sim.set_running(true);
+			std::this_thread::sleep_for(std::chrono::milliseconds(1 + pause % 5));
+			sim.set_running(false);
+			std::this_thread::sleep_for(50ms);
+			sim.update_frame();
+			shown = sim.frame().generation_;
+		}
+		// The thread is gone, and the grid is ours to look at.
+		CHECK(shown == grid.generation_);
+	}
+	grid_free(&grid);
+}
+
+TEST(simulation_settings_do_not_wait_for_a_step)
+{
+	Grid grid = grid_init(256, 256);
+	grid_randomize(&grid, 0.3, 5);
+	board_view view = board_view_fit(256, 256, 256, 256);
+	std::atomic<bool> stepping = false;
+	{
+		// Every step takes at least 300 ms.
+		simulation sim(&grid, 0, step_speed(), view, [&stepping](Grid*) {
+			stepping = true;
+			std::this_thread::sleep_for(300ms);
+		});
+		sim.set_running(true);
+		while (!stepping) std::this_thread::sleep_for(1ms);
+
+		const auto start = std::chrono::steady_clock::now();
+		view = board_view_zoom(view, 1);
+		sim.set_view(view);
+		step_speed speed;
+		speed.generations_ = 4;
+		sim.set_speed(speed);
+		sim.set_running(false);
+		CHECK(std::chrono::steady_clock::now() - start < 100ms);
+		CHECK(!sim.running());
+
+		// The new view shows once the step is done.
+		const auto give_up = std::chrono::steady_clock::now() + 2s;
+		while (!(sim.frame().view_ == view) && std::chrono::steady_clock::now() < give_up) {
+			sim.update_frame();
+			std::this_thread::sleep_for(1ms);
+		}
+		CHECK(sim.frame().view_ == view);
+	}
+	grid_free(&grid);
+}
+
+TEST(simulation_edits_do_not_wait_for_a_long_step)
+{
+	Grid grid = grid_init(512, 512);
+	grid_randomize(&grid, 0.3, 7);
+	const board_view view = board_view_fit(512, 512, 512, 512);
+	step_speed speed;
+	// Hours of generations in one step.
+	speed.generations_ = uint64_t(1) << 30;
+	{
+		simulation sim(&grid, 0, speed, view, nullptr);
+		sim.set_running(true);
+		uint64_t generation = 0;
+		for (int edit = 0; edit < 5; ++edit) {
+			std::this_thread::sleep_for(20ms);
+			const auto start = std::chrono::steady_clock::now();
+			sim.edit([&generation](Grid* grid) {
+				write_cell(grid, 1, 1, true);
+				generation = grid->generation_;
+			});
+			CHECK(std::chrono::steady_clock::now() - start < 200ms);
+			CHECK(generation != 0 && generation < speed.generations_);
+		}
+		// So do new settings: a slower speed drops what is left of the step, and single generations show.
+		speed.generations_ = 1;
+		sim.set_speed(speed);
+		std::this_thread::sleep_for(20ms);
+		sim.set_running(false);
+		std::this_thread::sleep_for(50ms);
+		sim.update_frame();
+		CHECK(sim.frame().generation_ > generation);
+	}
+	grid_free(&grid);
+}
@@ -0,0 +1,108 @@
+// The dirty rectangle of a surface, which decides what is uploaded to the screen.
+#include "test.hpp"
+#include <tmpl8/surface.hpp>
+#include <algorithm>
+#include <string>
+#include <vector>
+
+using tmpl8::rect;
+using tmpl8::surface;
+
+namespace
+{
+	bool same_rect(const rect& a, const rect& b)
+	{
+		return a.x1 == b.x1 && a.y1 == b.y1 && a.x2 == b.x2 && a.y2 == b.y2;
+	}
+
+	// The pixels of screen that differ from before, as one rectangle.
+	rect changed_pixels(const surface& screen, const std::vector<pixel>& before)
+	{
+		rect changed{ screen.width(), screen.height(), 0, 0 };
+		for (int32_t y = 0; y < screen.height(); ++y) {
+			for (int32_t x = 0; x < screen.width(); ++x) {
+				if (screen(x, y) == before[y * screen.pitch() + x]) continue;
+				changed.x1 = std::min(changed.x1, x);
+				changed.y1 = std::min(changed.y1, y);
+				changed.x2 = std::max(changed.x2, x + 1);
+				changed.y2 = std::max(changed.y2, y + 1);
+			}
+		}
+		return changed;
+	}
+
+	bool covers(const rect& outer, const rect& inner)
+	{
+		return outer.x1 <= inner.x1 && outer.y1 <= inner.y1 && outer.x2 >= inner.x2 && outer.y2 >= inner.y2;
+	}
+
+	// Draws on a clean screen and checks that the pixels it changed are dirty: exactly
+	// those, or for shapes whose bounds are not known up front, at least those.
+	template <typename t_draw>
+	bool marks_what_it_draws(surface& screen, bool exactly, t_draw draw)
+	{
+		screen.clear(0);
+		screen.take_dirty();
+		const std::vector<pixel> before(screen.buffer(), screen.buffer() + screen.pitch() * screen.height());
+		draw();
+		const rect changed = changed_pixels(screen, before);
+		const rect dirty = screen.take_dirty();
+		return !changed.empty() && (exactly ? same_rect(dirty, changed) : covers(dirty, changed)) && screen.dirty().empty();
+	}
+}
+
+TEST(surface_dirty_rect_unions_and_clips)
+{
+	surface screen(100, 50);
+	CHECK(same_rect(screen.take_dirty(), { 0, 0, 100, 50 }));
+	CHECK(screen.dirty().empty());
+	CHECK(surface().dirty().empty());
+
+	screen.mark_dirty({ 10, 20, 15, 25 });
+	CHECK(same_rect(screen.dirty(), { 10, 20, 15, 25 }));
+	screen.mark_dirty({ 40, 5, 41, 6 });
+	CHECK(same_rect(screen.dirty(), { 10, 5, 41, 25 }));
+	// Nothing to add: empty, or wholly off the surface.
+	screen.mark_dirty({ 60, 30, 60, 40 });
+	screen.mark_dirty({ 200, 10, 210, 20 });
+	screen.mark_dirty({ -20, -20, -10, -10 });
+	CHECK(same_rect(screen.dirty(), { 10, 5, 41, 25 }));
+	screen.mark_dirty({ -5, 30, 3, 80 });
+	CHECK(same_rect(screen.dirty(), { 0, 5, 41, 50 }));
+
+	CHECK(same_rect(screen.take_dirty(), { 0, 5, 41, 50 }));
+	CHECK(screen.dirty().empty());
+	CHECK(screen.take_dirty().empty());
+
+	screen.mark_dirty({ 90, 45, 120, 70 });
+	CHECK(same_rect(screen.take_dirty(), { 90, 45, 100, 50 }));
+	screen.mark_dirty();
+	CHECK(same_rect(screen.take_dirty(), { 0, 0, 100, 50 }));
+}
+
+TEST(surface_drawing_marks_its_bounds)
+{
+	surface screen(100, 50);
+	surface image(8, 4);
+	image.clear(0xff00ff00);
+
+	CHECK(marks_what_it_draws(screen, true, [&] { screen.plot(7, 9, 0xffffffff); }));
+	CHECK(marks_what_it_draws(screen, true, [&] { screen.bar(30, 40, 20, 10, 0xffffffff); }));
+	CHECK(marks_what_it_draws(screen, true, [&] { screen.bar(-10, 45, 8, 70, 0xffffffff); }));
+	CHECK(marks_what_it_draws(screen, true, [&] { screen.box(5, 6, 25, 16, 0xffffffff); }));
+	CHECK(marks_what_it_draws(screen, true, [&] { screen.box(90, 40, 130, 60, 0xffffffff); }));
+	CHECK(marks_what_it_draws(screen, false, [&] { screen.line(60.0f, 30.0f, 12.0f, 3.0f, 0xffffffff); }));
+	CHECK(marks_what_it_draws(screen, false, [&] { screen.print("dirty 42", 3, 20, 0xffffffff); }));
+	CHECK(marks_what_it_draws(screen, false, [&] { screen.print(std::string("x"), 50, 30, 0xffffffff); }));
+	CHECK(marks_what_it_draws(screen, true, [&] { screen.draw(image, 20, 30); }));
+	CHECK(marks_what_it_draws(screen, true, [&] { screen.draw(image, -3, 48); }));
+	CHECK(marks_what_it_draws(screen, true, [&] { screen.draw_blend(image, 96, -2); }));
+	CHECK(marks_what_it_draws(screen, true, [&] { screen.clear(0xff123456); }));
+
+	// Drawn wholly off the surface, or not at all: nothing is dirty.
+	screen.take_dirty();
+	screen.line(-5.0f, 3.0f, 20.0f, 3.0f, 0xffffffff);
+	screen.draw(image, 100, 10);
+	screen.draw(image, 10, -4);
+	CHECK(screen.dirty().empty());
+}
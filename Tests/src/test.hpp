@@ -0,0 +1,27 @@
+#pragma once
+
+// A minimal test harness: every test file registers its cases with TEST, and
+// CHECK reports a failed condition without stopping the case, so one run shows
+// everything that is off.
+
+namespace test
+{
+	typedef void (*test_fn)();
+
+	/** Registers a case at static initialisation; use TEST instead. */
+	struct registration
+	{
+		registration(const char* name, test_fn run);
+	};
+
+	/** @brief  Reports that condition, at file:line, does not hold in the running case. */
+	void fail(const char* condition, const char* file, int line);
+}
+
+#define TEST(name) \
+	static void name(); \
+	static test::registration name##_registration(#name, name); \
+	static void name()
+
+#define CHECK(condition) \
+	do { if (!(condition)) test::fail(#condition, __FILE__, __LINE__); } while (false)
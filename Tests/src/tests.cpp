@@ -0,0 +1,57 @@
+// Headless tests of the simulation code, run on build machines without a display:
+//
+//   tests [name...]
+//
+// runs every case, or only the named ones, and exits with 1 if any check failed.
+#include "test.hpp"
+#include <string.h>
+#include <stdio.h>
+#include <vector>
+
+namespace
+{
+	struct test_case
+	{
+		const char*  name_;
+		test::test_fn run_;
+	};
+
+	// A function-local static: registrations run before main, in no particular order.
+	std::vector<test_case>& test_cases()
+	{
+		static std::vector<test_case> cases;
+		return cases;
+	}
+
+	size_t failures = 0;
+}
+
+test::registration::registration(const char* name, test_fn run)
+{
+	test_cases().push_back({ name, run });
+}
+
+void test::fail(const char* condition, const char* file, int line)
+{
+	// Only the first few of a case: a broken kernel fails every cell.
+	if (++failures <= 20) fprintf(stderr, "%s:%d: CHECK(%s) failed\n", file, line, condition);
+}
+
+int main(int argc, char** argv)
+{
+	size_t failed_cases = 0, run_cases = 0;
+	for (const test_case& test_case : test_cases()) {
+		bool selected = argc == 1;
+		for (int i = 1; i < argc; ++i) selected |= strcmp(argv[i], test_case.name_) == 0;
+		if (!selected) continue;
+
+		const size_t failures_before = failures;
+		test_case.run_();
+		++run_cases;
+		const bool passed = failures == failures_before;
+		if (!passed) ++failed_cases;
+		printf("%s %s\n", passed ? "ok    " : "FAILED", test_case.name_);
+	}
+	printf("%zu of %zu cases passed\n", run_cases - failed_cases, run_cases);
+	return failed_cases == 0 ? 0 : 1;
+}